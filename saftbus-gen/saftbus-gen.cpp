@@ -374,6 +374,26 @@ struct FunctionSignature {
 		} else {
 			is_virtual = false;
 		}
+		// saftbus::View and saftbus::StringView point into the receive buffer of the Service.
+		// They can be used for input arguments, but not for outputs or return values.
+		if (is_view(return_type)) {
+			throw std::runtime_error("function " + name + " cannot return a view type: " + return_type);
+		}
+		for (auto &argument: argument_list) {
+			if (argument.is_output && is_view(argument.type)) {
+				throw std::runtime_error("function " + name + " cannot have a view type as output argument: " + argument.definition());
+			}
+		}
+	}
+	static bool is_view(const std::string &type) {
+		return type.find("View<") != type.npos || type.find("StringView") != type.npos;
+	}
+	// functions with output arguments get no asynchronous variant in the Proxy
+	bool has_output_arguments() const {
+		for (auto &argument: argument_list) {
+			if (argument.is_output) return true;
+		}
+		return false;
 	}
 	void print() {
 		std::cerr << "  Function        " << std::endl;
@@ -1177,6 +1197,7 @@ void generate_service_implementation(const std::string &outputdirectory, ClassDe
 			}
 			out << ") {" << std::endl;
 			// out << "\t\t" << "std::cerr << \"service "<< class_definition.name << "::" << signal.name << " dispatch function called\" << std::endl;" << std::endl;
+			out << "\t\t" << "saftbus::LatencyTimer serialize_timer(saftbus::signal_serialize_latency);" << std::endl;
 			out << "\t\t" << "saftbus::Serializer serialized_signal;" << std::endl;
 			out << "\t\t" << "serialized_signal.put(get_object_id());" << std::endl;
 			out << "\t\t" << "serialized_signal.put(" << interface_no    << ");" << std::endl;
@@ -1184,6 +1205,7 @@ void generate_service_implementation(const std::string &outputdirectory, ClassDe
 			for (unsigned i = 0; i < signal.argument_list.size(); ++i) {
 				out << "\t\t" << "serialized_signal.put(" << signal.argument_list[i].name << ");" << std::endl;
 			}
+			out << "\t\t" << "serialize_timer.stop();" << std::endl;
 			out << "\t\t" << "emit(serialized_signal);" << std::endl;
 			out << "\t" << "}" << std::endl;
 		}
@@ -1215,6 +1237,7 @@ void generate_proxy_header(const std::string &outputdirectory, ClassDefinition &
 	header_out << "#define " << class_definition.name << "_PROXY_HPP_" << std::endl;
 	header_out << std::endl;
 	header_out << "#include <saftbus/client.hpp>" << std::endl;	
+	header_out << "#include <future>" << std::endl;	
 	header_out << std::endl;
 
 	bool have_sigc_signals = false;
@@ -1296,6 +1319,17 @@ void generate_proxy_header(const std::string &outputdirectory, ClassDefinition &
 			}
 		}
 		header_out << ");" << std::endl;
+		if (!function.has_output_arguments()) {
+			header_out << "\t\t" << "/// @brief asynchronous variant of " << function.name << ": the request is sent immediately, the reply is read by get() of the returned future." << std::endl;
+			header_out << "\t\t" << "std::future<" << function.return_type << "> " << function.name << "_async(";
+			for (unsigned i = 0; i < function.argument_list.size(); ++i) {
+				header_out << function.argument_list[i].declaration();
+				if (i != function.argument_list.size()-1) {
+					header_out << ", ";
+				}
+			}
+			header_out << ");" << std::endl;
+		}
 	}
 
 	// signals
@@ -1441,6 +1475,8 @@ void generate_proxy_implementation(const std::string &outputdirectory, ClassDefi
 		}
 		cpp_out << "\t) {" << std::endl;
 		cpp_out << "\t\t" << "std::lock_guard<std::mutex> lock(get_proxy_mutex());" << std::endl;
+		cpp_out << "\t\t" << "uint32_t request_id_ = get_connection().new_request_id();" << std::endl;
+		cpp_out << "\t\t" << "get_send().put(request_id_);" << std::endl;
 		cpp_out << "\t\t" << "get_send().put(get_saftbus_object_id());" << std::endl;
 		cpp_out << "\t\t" << "get_send().put(interface_no);" << std::endl;
 		cpp_out << "\t\t" << "get_send().put(" << function_no  << "); // function_no" << std::endl;
@@ -1460,7 +1496,7 @@ void generate_proxy_implementation(const std::string &outputdirectory, ClassDefi
 		// cpp_out << "\t\t\t" << "get_connection().send(get_send());" << std::endl;
 		// cpp_out << "\t\t\t" << "get_connection().receive(get_received());" << std::endl;
 		// cpp_out << "\t\t}" << std::endl;
-		cpp_out << "\t\t" << "get_connection().atomic_send_and_receive(get_send(), get_received());" << std::endl;
+		cpp_out << "\t\t" << "get_connection().atomic_send_and_receive(request_id_, get_send(), get_received());" << std::endl;
 
 		cpp_out << "\t\t" << "saftbus::FunctionResult function_result_;" << std::endl;
 		cpp_out << "\t\t" << "get_received().get(function_result_);" << std::endl;
@@ -1484,6 +1520,63 @@ void generate_proxy_implementation(const std::string &outputdirectory, ClassDefi
 		}
 
 		cpp_out << "\t}" << std::endl;
+
+		// The asynchronous variant only sends the request. The reply is matched by its request id 
+		// when get() is called on the future. Replies to other requests are kept by the ClientConnection
+		// in the meantime, so many requests can be in flight at the same time.
+		if (function.has_output_arguments()) {
+			continue;
+		}
+		cpp_out << "\t" << "std::future<" << function.return_type << "> " << class_definition.name << "_Proxy::" << function.name << "_async(";
+		for (unsigned i = 0; i < function.argument_list.size(); ++i) {
+			cpp_out << function.argument_list[i].definition();
+			if (i != function.argument_list.size()-1) {
+				cpp_out << ", ";
+			}
+		}
+		cpp_out << "\t) {" << std::endl;
+		cpp_out << "\t\t" << "std::lock_guard<std::mutex> lock(get_proxy_mutex());" << std::endl;
+		cpp_out << "\t\t" << "uint32_t request_id_ = get_connection().new_request_id();" << std::endl;
+		cpp_out << "\t\t" << "get_send().put(request_id_);" << std::endl;
+		cpp_out << "\t\t" << "get_send().put(get_saftbus_object_id());" << std::endl;
+		cpp_out << "\t\t" << "get_send().put(interface_no);" << std::endl;
+		cpp_out << "\t\t" << "get_send().put(" << function_no  << "); // function_no" << std::endl;
+		for (unsigned i = 0; i < function.argument_list.size(); ++i) {
+			cpp_out << "\t\t" << "get_send().put(" << function.argument_list[i].name << ");" << std::endl;
+		}
+		// A failed send is reported by get() of the returned future.
+		// If the future is dropped without get(), the PendingReply makes the ClientConnection drop the reply.
+		cpp_out << "\t\t" << "std::shared_ptr<saftbus::ClientConnection> connection_ = get_shared_connection();" << std::endl;
+		cpp_out << "\t\t" << "try {" << std::endl;
+		cpp_out << "\t\t\t" << "if (connection_->send_request(get_send()) <= 0) {" << std::endl;
+		cpp_out << "\t\t\t\t" << "throw saftbus::Error(\"cannot send request to server\");" << std::endl;
+		cpp_out << "\t\t\t" << "}" << std::endl;
+		cpp_out << "\t\t" << "} catch (...) {" << std::endl;
+		cpp_out << "\t\t\t" << "std::promise<" << function.return_type << "> failed_;" << std::endl;
+		cpp_out << "\t\t\t" << "failed_.set_exception(std::current_exception());" << std::endl;
+		cpp_out << "\t\t\t" << "return failed_.get_future();" << std::endl;
+		cpp_out << "\t\t" << "}" << std::endl;
+		cpp_out << "\t\t" << "std::shared_ptr<saftbus::PendingReply> reply_ = std::make_shared<saftbus::PendingReply>(connection_, request_id_);" << std::endl;
+		cpp_out << "\t\t" << "return std::async(std::launch::deferred, [reply_]() {" << std::endl;
+		cpp_out << "\t\t\t" << "saftbus::Deserializer received_;" << std::endl;
+		cpp_out << "\t\t\t" << "if (reply_->receive(received_) <= 0) {" << std::endl;
+		cpp_out << "\t\t\t\t" << "throw saftbus::Error(\"cannot receive reply from server\");" << std::endl;
+		cpp_out << "\t\t\t" << "}" << std::endl;
+		cpp_out << "\t\t\t" << "saftbus::FunctionResult function_result_;" << std::endl;
+		cpp_out << "\t\t\t" << "received_.get(function_result_);" << std::endl;
+		cpp_out << "\t\t\t" << "if (function_result_ == saftbus::FunctionResult::EXCEPTION) {" << std::endl;
+		cpp_out << "\t\t\t\t" << "std::string what;" << std::endl;
+		cpp_out << "\t\t\t\t" << "received_.get(what);" << std::endl;
+		cpp_out << "\t\t\t\t" << "throw saftbus::Error(what);" << std::endl;
+		cpp_out << "\t\t\t" << "}" << std::endl;
+		cpp_out << "\t\t\t" << "assert(function_result_ == saftbus::FunctionResult::RETURN);" << std::endl;
+		if (function.return_type != "void") {
+			cpp_out << "\t\t\t" << function.return_type << " return_value_result_;" << std::endl;
+			cpp_out << "\t\t\t" << "received_.get(return_value_result_);" << std::endl;
+			cpp_out << "\t\t\t" << "return return_value_result_;" << std::endl;
+		}
+		cpp_out << "\t\t" << "});" << std::endl;
+		cpp_out << "\t}" << std::endl;
 	}
 
 	cpp_out << std::endl;
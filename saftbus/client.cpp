@@ -25,6 +25,9 @@
 #include <sstream>
 #include <iostream>
 #include <mutex>
+#include <atomic>
+#include <map>
+#include <set>
 #include <cassert>
 
 #include <sys/types.h>
@@ -43,14 +46,30 @@ namespace saftbus {
 		static std::mutex base_socket_mutex;
 		std::mutex fd_mutex;
 		std::mutex connection_mutex;
+		std::unique_ptr<BulkBuffer> bulk; // shared memory for large messages (nullptr if not available)
+		std::atomic<uint32_t> next_request_id;
+		std::map<uint32_t, std::unique_ptr<Deserializer> > early_replies; // replies that arrived while waiting for another reply
+		std::set<uint32_t> discarded_replies; // nobody waits for these replies, they are dropped when they arrive
+		void keep_reply(uint32_t reply_id, std::unique_ptr<Deserializer> reply);
 	};
 	std::mutex ClientConnection::Impl::base_socket_mutex;
 
+	// has to be called with the connection mutex locked
+	void ClientConnection::Impl::keep_reply(uint32_t reply_id, std::unique_ptr<Deserializer> reply) {
+		auto discarded = discarded_replies.find(reply_id);
+		if (discarded != discarded_replies.end()) {
+			discarded_replies.erase(discarded);
+			return;
+		}
+		early_replies[reply_id] = std::move(reply);
+	}
+
 
 	ClientConnection::ClientConnection(const std::string &socket_name) 
 		: d(new Impl)
 	{
 		std::lock_guard<std::mutex> lock1(d->base_socket_mutex);
+		d->next_request_id = 0;
 
 		std::ostringstream msg;
 		// msg << "ClientConnection constructor : ";
@@ -100,6 +119,21 @@ namespace saftbus {
 			throw saftbus::Error(msg.str());
 		}
 
+		// create a shared memory region for large messages and send it to the server
+		int bulk_fd = BulkBuffer::create();
+		int has_bulk = (bulk_fd != -1);
+		if (write(d->pfd.fd, &has_bulk, sizeof(has_bulk)) != sizeof(has_bulk)) {
+			msg << "cannot send bulk buffer flag" << strerror(errno) << std::endl;
+			throw saftbus::Error(msg.str());
+		}
+		if (has_bulk) {
+			d->bulk.reset(new BulkBuffer(bulk_fd));
+			if (sendfd(d->pfd.fd, bulk_fd) == -1) {
+				msg << "cannot send bulk buffer: " << strerror(errno);
+				throw saftbus::Error(msg.str());
+			}
+		}
+
 		if (read(d->pfd.fd, &d->client_id, sizeof(d->client_id)) != sizeof(d->client_id)) {
 			msg << "cannot read client id" << strerror(errno) << std::endl;
 			throw saftbus::Error(msg.str());
@@ -120,7 +154,7 @@ namespace saftbus {
 		int result;
 		if ((result = poll(&d->pfd, 1, timeout_ms)) > 0) {
 			if (d->pfd.revents & POLLOUT) {
-				serializer.write_to(d->pfd.fd);
+				serializer.write_to(d->pfd.fd, d->bulk.get());
 			}
 			if (d->pfd.revents & POLLHUP) {
 				return -1;
@@ -134,8 +168,11 @@ namespace saftbus {
 		int result;
 		d->pfd.events = POLLIN | POLLHUP;
 		if ((result = poll(&d->pfd, 1, timeout_ms)) > 0) {
-			if (d->pfd.revents & POLLIN) {
-				deserializer.read_from(d->pfd.fd);
+			if (d->pfd.revents & POLLIN) { // there may be data even if the server hung up
+				if (!deserializer.read_from(d->pfd.fd, d->bulk.get())) {
+					return -1;
+				}
+				return result;
 			}
 			if (d->pfd.revents & POLLHUP) {
 				return -1;
@@ -144,10 +181,146 @@ namespace saftbus {
 		return result;
 	}
 
-	int ClientConnection::atomic_send_and_receive(Serializer &serializer, Deserializer &deserializer, int timeout_ms) {
+	uint32_t ClientConnection::new_request_id() {
+		return d->next_request_id++;
+	}
+
+	struct Batch::Impl {
+		Serializer calls;
+		unsigned num_calls;
+		ClientConnection *connection; // all collected calls go to this connection
+		Batch *previous; // the Batch that was active in this thread before this one was created
+	};
+	// the Batch that collects the asynchronous calls of this thread
+	static thread_local Batch *active_batch = nullptr;
+
+	int ClientConnection::send_request(Serializer &serializer) {
+		if (active_batch != nullptr) {
+			if (active_batch->d->connection != this) { // a Batch can only be sent over one connection
+				active_batch->execute();
+				active_batch->d->connection = this;
+			}
+			active_batch->d->calls.put(serializer);
+			++active_batch->d->num_calls;
+			return 1;
+		}
+		std::lock_guard<std::mutex> lock(d->connection_mutex);
+		return send_request_locked(serializer);
+	}
+
+	int ClientConnection::send_request_locked(Serializer &serializer) {
+		std::lock_guard<std::mutex> fd_lock(d->fd_mutex);
+		// The server may be blocked writing replies to us while we write the request.
+		// Therefore replies are read whenever they arrive before the next record is written.
+		bool result = serializer.write_to(d->pfd.fd, d->bulk.get(), [this](int) {
+			for (;;) {
+				d->pfd.events = POLLOUT | POLLIN;
+				if (poll(&d->pfd, 1, -1) > 0) {
+					if (d->pfd.revents & POLLIN) {
+						if (!stash_reply()) {
+							throw saftbus::Error("cannot receive reply from server");
+						}
+					} else if (d->pfd.revents & (POLLHUP | POLLERR)) {
+						throw saftbus::Error("server hung up");
+					} else if (d->pfd.revents & POLLOUT) {
+						return;
+					}
+				}
+			}
+		});
+		return result?1:-1;
+	}
+
+	int ClientConnection::receive_reply(uint32_t request_id, Deserializer &deserializer, int timeout_ms) {
+		if (active_batch != nullptr) { // the reply may be waiting for the execution of the batch
+			active_batch->execute();
+		}
+		std::lock_guard<std::mutex> lock(d->connection_mutex);
+		return receive_reply_locked(request_id, deserializer, timeout_ms);
+	}
+
+	int ClientConnection::receive_reply_locked(uint32_t request_id, Deserializer &deserializer, int timeout_ms) {
+		auto early_reply = d->early_replies.find(request_id);
+		if (early_reply != d->early_replies.end()) {
+			deserializer.swap(*early_reply->second);
+			d->early_replies.erase(early_reply);
+			return 1;
+		}
+		for (;;) {
+			int result = receive(deserializer, timeout_ms);
+			if (result <= 0) {
+				return result;
+			}
+			uint32_t reply_id;
+			deserializer.get(reply_id);
+			if (reply_id == request_id) {
+				return result;
+			}
+			// this is the reply to another request, keep it for later
+			std::unique_ptr<Deserializer> early(new Deserializer(0));
+			early->swap(deserializer);
+			d->keep_reply(reply_id, std::move(early));
+		}
+	}
+
+	void ClientConnection::discard_reply(uint32_t request_id) {
+		std::lock_guard<std::mutex> lock(d->connection_mutex);
+		if (d->early_replies.erase(request_id) == 0) {
+			d->discarded_replies.insert(request_id);
+		}
+	}
+
+	bool ClientConnection::stash_reply() {
+		std::unique_ptr<Deserializer> reply(new Deserializer(0));
+		if (!reply->read_from(d->pfd.fd, d->bulk.get())) {
+			return false;
+		}
+		uint32_t reply_id;
+		reply->get(reply_id);
+		d->keep_reply(reply_id, std::move(reply));
+		return true;
+	}
+
+	int ClientConnection::execute_batch(Serializer &calls, unsigned num_calls) {
 		std::lock_guard<std::mutex> lock(d->connection_mutex);
-		int send_result    = send(serializer, timeout_ms);
-		int receive_result = receive(deserializer, timeout_ms);
+		Serializer request;
+		Deserializer reply;
+		uint32_t request_id = new_request_id();
+		request.put(request_id);
+		request.put(1u); // the Container_Service
+		request.put(0);  // interface_no
+		request.put(container_function::execute_batch);
+		request.put(num_calls);
+		request.put(calls);
+		if (send_request_locked(request) <= 0 || receive_reply_locked(request_id, reply, -1) <= 0) {
+			return -1;
+		}
+		saftbus::FunctionResult function_result;
+		reply.get(function_result);
+		if (function_result == saftbus::FunctionResult::EXCEPTION) {
+			std::string what;
+			reply.get(what);
+			throw saftbus::Error(what);
+		}
+		// the nested replies are kept until they are asked for
+		reply.get(num_calls);
+		for (unsigned i = 0; i < num_calls; ++i) {
+			std::unique_ptr<Deserializer> nested(new Deserializer(0));
+			reply.get(*nested);
+			uint32_t reply_id;
+			nested->get(reply_id);
+			d->keep_reply(reply_id, std::move(nested));
+		}
+		return 1;
+	}
+
+	int ClientConnection::atomic_send_and_receive(uint32_t request_id, Serializer &serializer, Deserializer &deserializer, int timeout_ms) {
+		if (active_batch != nullptr) { // collected calls were made before this one and have to be executed first
+			active_batch->execute();
+		}
+		std::lock_guard<std::mutex> lock(d->connection_mutex);
+		int send_result    = send_request_locked(serializer);
+		int receive_result = receive_reply_locked(request_id, deserializer, timeout_ms);
 		if (send_result < 0 || receive_result < 0) {
 			return -1;
 		}
@@ -157,6 +330,63 @@ namespace saftbus {
 		return 0;
 	}
 
+	Batch::Batch()
+		: d(new Impl)
+	{
+		d->num_calls = 0;
+		d->connection = nullptr;
+		d->previous = active_batch;
+		active_batch = this;
+	}
+	Batch::~Batch()
+	{
+		active_batch = d->previous;
+		try {
+			if (d->num_calls > 0) {
+				d->connection->execute_batch(d->calls, d->num_calls);
+			}
+		} catch (std::exception &e) {
+			std::cerr << "Exception in " << __FUNCTION__ << " : " << e.what() << std::endl;
+		}
+	}
+	void Batch::execute()
+	{
+		if (d->num_calls == 0) {
+			return;
+		}
+		unsigned num_calls = d->num_calls;
+		d->num_calls = 0;
+		if (d->connection->execute_batch(d->calls, num_calls) <= 0) {
+			throw saftbus::Error("Batch cannot execute calls");
+		}
+	}
+	unsigned Batch::size()
+	{
+		return d->num_calls;
+	}
+
+	PendingReply::PendingReply(const std::shared_ptr<ClientConnection> &connection_, uint32_t request_id_)
+		: connection(connection_), request_id(request_id_), received(false)
+	{
+	}
+	PendingReply::~PendingReply()
+	{
+		std::shared_ptr<ClientConnection> alive = connection.lock();
+		if (!received && alive) {
+			alive->discard_reply(request_id);
+		}
+	}
+	int PendingReply::receive(Deserializer &deserializer, int timeout_ms)
+	{
+		std::shared_ptr<ClientConnection> alive = connection.lock();
+		if (!alive) { // e.g. the SignalGroup that owned the connection was destroyed
+			throw saftbus::Error("connection to server was closed before the reply was received");
+		}
+		int result = alive->receive_reply(request_id, deserializer, timeout_ms);
+		received = (result != 0); // after a timeout the reply may still be received later
+		return result;
+	}
+
 	/////////////////////////////
 	/////////////////////////////
 	/////////////////////////////
@@ -169,11 +399,14 @@ namespace saftbus {
 		std::vector<Proxy*> proxies;
 		std::mutex signal_group_mutex;
 		std::mutex fd_mutex;
+		std::shared_ptr<ClientConnection> connection; // only if the SignalGroup has its own connection
 	};
 
 	struct Proxy::Impl {
-		static std::shared_ptr<ClientConnection> connection;
+		static std::shared_ptr<ClientConnection> connection; // shared by all Proxies that don't use the connection of their SignalGroup
 		static std::mutex connection_mutex;
+		static std::shared_ptr<ClientConnection> get_process_connection();
+		std::shared_ptr<ClientConnection> proxy_connection;
 		std::mutex proxy_mutex;
 		int saftbus_object_id;
 		int client_id, signal_group_id; // is determined at registration time and needs to be saved for de-registration
@@ -186,9 +419,12 @@ namespace saftbus {
 	std::shared_ptr<ClientConnection> Proxy::Impl::connection;
 	std::mutex                        Proxy::Impl::connection_mutex;
 
-	SignalGroup::SignalGroup() 
+	SignalGroup::SignalGroup(bool own_connection) 
 		: d(new Impl)
 	{
+		if (own_connection) {
+			d->connection.reset(new ClientConnection);
+		}
 		// std::cerr << "SignalGroup constructor" << std::endl;
 		std::ostringstream msg;
 		if (socketpair(AF_LOCAL, SOCK_SEQPACKET, 0, d->fd_pair) != 0) {
@@ -211,7 +447,7 @@ namespace saftbus {
 		// std::cerr << "register_proxy: keeping one fd " << d->fd_pair[1] << " for us to receive signals " << std::endl;
 
 		if (d->signal_group_id == -1) {
-			int fdresult = sendfd(Proxy::get_connection().d->pfd.fd, d->fd_pair[0]);
+			int fdresult = sendfd(proxy->get_connection().d->pfd.fd, d->fd_pair[0]);
 			close(d->fd_pair[0]); // close the fd after sending it to the server
 			                      // if this is not closed, we will not receiver POLLHUP
 			                      // when the server closed the other end (because here we
@@ -318,11 +554,18 @@ namespace saftbus {
 	{
 		// std::cerr << "Proxy constructor for " << object_path << std::endl;
 		d->signal_group = &signal_group;
+		if (signal_group.d->connection) {
+			d->proxy_connection = signal_group.d->connection;
+		} else {
+			d->proxy_connection = Proxy::Impl::get_process_connection();
+		}
 		// the Proxy constructor calls the server  
 		// with object_id = 1 (the Container_Service)
 		unsigned container_service_object_id = 1;
 		int interface_no = 0; // Container_Service has only 1 interface with interface_no 0
-		int function_no = 0; // function_no 0 is register_proxy
+		int function_no = container_function::register_proxy;
+		uint32_t request_id = get_connection().new_request_id();
+		d->send.put(request_id);
 		d->send.put(container_service_object_id);
 		d->send.put(interface_no);
 		d->send.put(function_no);
@@ -331,12 +574,12 @@ namespace saftbus {
 		{
 			d->send.put(signal_group.d->signal_group_id); 
 			std::lock_guard<std::mutex> lock(get_client_socket_mutex());
-			int send_result = get_connection().send(d->send);
+			int send_result = get_connection().send_request_locked(d->send);
 			if (send_result <= 0) {
 				throw saftbus::Error("Proxy cannot send data to server");
 			}
 			signal_group.register_proxy(this);
-			int receive_result = get_connection().receive(d->received);
+			int receive_result = get_connection().receive_reply_locked(request_id, d->received, -1);
 			if (receive_result <= 0) {
 				throw saftbus::Error("Proxy cannot receive data from server");
 			}
@@ -373,17 +616,20 @@ namespace saftbus {
 		// client connection is shared among threads
 		// only one thread can access the connection at a time
 		std::lock_guard<std::mutex> mutex_lock(d->proxy_mutex);
+		d->send.put(get_connection().new_request_id()); // there is no reply to unregister_proxy
 		d->send.put(1); // 1 is the special object id that adresses the ContainerService wich provides the unregister_proxy method
 		int interface_no = 0;
-		int function_no = 1; // 1 is unregister_proxy
+		int function_no = container_function::unregister_proxy;
 		d->send.put(interface_no);
 		d->send.put(function_no); 
 		d->send.put(d->saftbus_object_id);
 		d->send.put(d->client_id);
 		d->send.put(d->signal_group_id);
-		{
+		try {
 			std::lock_guard<std::mutex> lock(get_client_socket_mutex());
-			get_connection().send(d->send);
+			get_connection().send_request_locked(d->send);
+		} catch (saftbus::Error &e) {
+			// the server is gone, there is nothing to unregister
 		}
 		d->signal_group->unregister_proxy(this);
 	}
@@ -396,12 +642,18 @@ namespace saftbus {
 		return *d->signal_group;
 	}
 
-	ClientConnection& Proxy::get_connection() {
+	std::shared_ptr<ClientConnection> Proxy::Impl::get_process_connection() {
 		std::lock_guard<std::mutex> lock(Proxy::Impl::connection_mutex);
 		if (!Proxy::Impl::connection) {
 			Proxy::Impl::connection = std::make_shared<ClientConnection>();
 		}
-		return *(Proxy::Impl::connection);
+		return Proxy::Impl::connection;
+	}
+	ClientConnection& Proxy::get_connection() {
+		return *d->proxy_connection;
+	}
+	std::shared_ptr<ClientConnection> Proxy::get_shared_connection() {
+		return d->proxy_connection;
 	}
 	Serializer& Proxy::get_send()
 	{
@@ -456,12 +708,14 @@ namespace saftbus {
 	}
 	bool Container_Proxy::load_plugin(const std::string & so_filename, const std::vector<std::string> &plugin_args) {
 		std::lock_guard<std::mutex> mutex_lock(get_proxy_mutex());
+		uint32_t request_id_ = get_connection().new_request_id();
+		get_send().put(request_id_);
 		get_send().put(get_saftbus_object_id());
 		get_send().put(interface_no);
-		get_send().put(2); // function_no
+		get_send().put(container_function::load_plugin);
 		get_send().put(so_filename);
 		get_send().put(plugin_args);
-		get_connection().atomic_send_and_receive(get_send(), get_received());
+		get_connection().atomic_send_and_receive(request_id_, get_send(), get_received());
 		saftbus::FunctionResult function_result_;
 		get_received().get(function_result_);
 		if (function_result_ == saftbus::FunctionResult::EXCEPTION) {
@@ -476,12 +730,14 @@ namespace saftbus {
 	}
 	bool Container_Proxy::unload_plugin(const std::string & so_filename, const std::vector<std::string> &plugin_args) {
 		std::lock_guard<std::mutex> mutex_lock(get_proxy_mutex());
+		uint32_t request_id_ = get_connection().new_request_id();
+		get_send().put(request_id_);
 		get_send().put(get_saftbus_object_id());
 		get_send().put(interface_no);
-		get_send().put(3); // function_no
+		get_send().put(container_function::unload_plugin);
 		get_send().put(so_filename);
 		get_send().put(plugin_args);
-		get_connection().atomic_send_and_receive(get_send(), get_received());
+		get_connection().atomic_send_and_receive(request_id_, get_send(), get_received());
 		saftbus::FunctionResult function_result_;
 		get_received().get(function_result_);
 		if (function_result_ == saftbus::FunctionResult::EXCEPTION) {
@@ -496,11 +752,13 @@ namespace saftbus {
 	}
 	bool Container_Proxy::remove_object(const std::string & object_path	) {
 		std::lock_guard<std::mutex> mutex_lock(get_proxy_mutex());
+		uint32_t request_id_ = get_connection().new_request_id();
+		get_send().put(request_id_);
 		get_send().put(get_saftbus_object_id());
 		get_send().put(interface_no);
-		get_send().put(4); // function_no
+		get_send().put(container_function::remove_object);
 		get_send().put(object_path);
-		get_connection().atomic_send_and_receive(get_send(), get_received());
+		get_connection().atomic_send_and_receive(request_id_, get_send(), get_received());
 		saftbus::FunctionResult function_result_;
 		get_received().get(function_result_);
 		if (function_result_ == saftbus::FunctionResult::EXCEPTION) {
@@ -515,10 +773,12 @@ namespace saftbus {
 	}
 	void Container_Proxy::quit(	) {
 		std::lock_guard<std::mutex> mutex_lock(get_proxy_mutex());
+		uint32_t request_id_ = get_connection().new_request_id();
+		get_send().put(request_id_);
 		get_send().put(get_saftbus_object_id());
 		get_send().put(interface_no);
-		get_send().put(5); // function_no
-		get_connection().atomic_send_and_receive(get_send(), get_received());
+		get_send().put(container_function::quit);
+		get_connection().atomic_send_and_receive(request_id_, get_send(), get_received());
 		saftbus::FunctionResult function_result_;
 		get_received().get(function_result_);
 		if (function_result_ == saftbus::FunctionResult::EXCEPTION) {
@@ -530,10 +790,12 @@ namespace saftbus {
 	}
 	SaftbusInfo Container_Proxy::get_status(	) {
 		std::lock_guard<std::mutex> mutex_lock(get_proxy_mutex());
+		uint32_t request_id_ = get_connection().new_request_id();
+		get_send().put(request_id_);
 		get_send().put(get_saftbus_object_id());
 		get_send().put(interface_no);
-		get_send().put(6); // function_no
-		get_connection().atomic_send_and_receive(get_send(), get_received());
+		get_send().put(container_function::get_status);
+		get_connection().atomic_send_and_receive(request_id_, get_send(), get_received());
 		saftbus::FunctionResult function_result_;
 		get_received().get(function_result_);
 		if (function_result_ == saftbus::FunctionResult::EXCEPTION) {
@@ -546,4 +808,107 @@ namespace saftbus {
 		get_received().get(return_value_result_);
 		return return_value_result_;
 	}
-}
\ No newline at end of file
+	std::map<std::string, std::vector<uint64_t> > Container_Proxy::get_latency_histograms(	) {
+		std::lock_guard<std::mutex> mutex_lock(get_proxy_mutex());
+		uint32_t request_id_ = get_connection().new_request_id();
+		get_send().put(request_id_);
+		get_send().put(get_saftbus_object_id());
+		get_send().put(interface_no);
+		get_send().put(container_function::get_latency_histograms);
+		get_connection().atomic_send_and_receive(request_id_, get_send(), get_received());
+		saftbus::FunctionResult function_result_;
+		get_received().get(function_result_);
+		if (function_result_ == saftbus::FunctionResult::EXCEPTION) {
+			std::string what;
+			get_received().get(what);
+			throw saftbus::Error(what);
+		}
+		assert(function_result_ == saftbus::FunctionResult::RETURN);
+		std::map<std::string, std::vector<uint64_t> > return_value_result_;
+		get_received().get(return_value_result_);
+		return return_value_result_;
+	}
+	void Container_Proxy::set_latency_histograms(bool enable, bool reset) {
+		std::lock_guard<std::mutex> mutex_lock(get_proxy_mutex());
+		uint32_t request_id_ = get_connection().new_request_id();
+		get_send().put(request_id_);
+		get_send().put(get_saftbus_object_id());
+		get_send().put(interface_no);
+		get_send().put(container_function::set_latency_histograms);
+		get_send().put(enable);
+		get_send().put(reset);
+		get_connection().atomic_send_and_receive(request_id_, get_send(), get_received());
+		saftbus::FunctionResult function_result_;
+		get_received().get(function_result_);
+		if (function_result_ == saftbus::FunctionResult::EXCEPTION) {
+			std::string what;
+			get_received().get(what);
+			throw saftbus::Error(what);
+		}
+		assert(function_result_ == saftbus::FunctionResult::RETURN);
+	}
+	std::vector<int> Container_Proxy::get_shared_fds(const std::string &object_path, const std::string &name) {
+		if (active_batch != nullptr) { // the request bypasses the Batch, collected calls have to be executed first
+			active_batch->execute();
+		}
+		std::lock_guard<std::mutex> mutex_lock(get_proxy_mutex());
+		// the server sends the file descriptors through a socket that we send after the request
+		int back_channel[2];
+		if (socketpair(AF_LOCAL, SOCK_SEQPACKET, 0, back_channel) != 0) {
+			std::ostringstream msg;
+			msg << "cannot create socket pair: " << strerror(errno);
+			throw saftbus::Error(msg.str());
+		}
+		uint32_t request_id_ = get_connection().new_request_id();
+		get_send().put(request_id_);
+		get_send().put(get_saftbus_object_id());
+		get_send().put(interface_no);
+		get_send().put(container_function::get_shared_fds);
+		get_send().put(object_path);
+		get_send().put(name);
+		{
+			std::lock_guard<std::mutex> lock(get_client_socket_mutex());
+			int send_result = get_connection().send_request_locked(get_send());
+			int fd_result   = -1;
+			if (send_result > 0) {
+				fd_result = sendfd(get_connection().d->pfd.fd, back_channel[0]);
+			}
+			close(back_channel[0]);
+			if (send_result <= 0 || fd_result <= 0) {
+				close(back_channel[1]);
+				throw saftbus::Error("Container_Proxy::get_shared_fds cannot send request to server");
+			}
+			if (get_connection().receive_reply_locked(request_id_, get_received(), -1) <= 0) {
+				close(back_channel[1]);
+				throw saftbus::Error("Container_Proxy::get_shared_fds cannot receive reply from server");
+			}
+		}
+		saftbus::FunctionResult function_result_;
+		get_received().get(function_result_);
+		if (function_result_ == saftbus::FunctionResult::EXCEPTION) {
+			close(back_channel[1]);
+			std::string what;
+			get_received().get(what);
+			throw saftbus::Error(what);
+		}
+		assert(function_result_ == saftbus::FunctionResult::RETURN);
+		unsigned num_fds;
+		get_received().get(num_fds);
+		std::vector<int> fds;
+		for (unsigned i = 0; i < num_fds; ++i) {
+			int fd = recvfd(back_channel[1]);
+			if (fd == -1) {
+				break;
+			}
+			fds.push_back(fd);
+		}
+		close(back_channel[1]);
+		if (fds.size() != num_fds) {
+			for (int fd: fds) {
+				close(fd);
+			}
+			throw saftbus::Error("Container_Proxy::get_shared_fds cannot receive file descriptors");
+		}
+		return fds;
+	}
+}
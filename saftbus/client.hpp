@@ -45,6 +45,8 @@ namespace saftbus {
 		struct Impl; std::unique_ptr<Impl> d;		
 	friend class SignalGroup;
 	friend class Proxy;
+	friend class Batch;
+	friend class Container_Proxy;
 	public:
 		ClientConnection(const std::string &socket_name = "/var/run/saftbus/saftbus");
 		~ClientConnection();
@@ -61,16 +63,74 @@ namespace saftbus {
 		/// @return 0 in case of timeout, >0 in case of success, -1 in case of error
 		int receive(Deserializer &deserializer, int timeout_ms = -1);
 
-		/// @brief call send and receiver atomically
+		/// @brief get a new request id.
 		///
-		/// @param serializer should contain serialized data
-		/// @param deserializer that contains the received buffer after the function returns
+		/// Each request starts with a request id, and the server starts the reply with the same id.
+		/// This allows to have several requests in flight and match the replies to them.
+		/// @return a request id that is unique for this connection
+		uint32_t new_request_id();
+
+		/// @brief send a request without waiting for the reply. The reply has to be fetched with receive_reply.
+		///
+		/// Replies that arrive while the request is written are kept, so that the server never 
+		/// blocks on a full socket while many requests are in flight.
+		/// @param serializer should contain serialized data, starting with a request id
+		/// @return >0 in case of success, -1 in case of error
+		int send_request(Serializer &serializer);
+
+		/// @brief wait for the reply to a request
+		///
+		/// Replies to other requests that arrive in the meantime are kept until they are asked for.
+		/// @param request_id the request id that was put into the request
+		/// @param deserializer that contains the reply after the function returns (the request id is already consumed)
+		/// @param timeout return after so many milliseconds even if the data could not be sent.
+		/// @return 0 in case of timeout, >0 in case of success, -1 in case of error
+		int receive_reply(uint32_t request_id, Deserializer &deserializer, int timeout_ms = -1);
+
+		/// @brief call send_request and receive_reply atomically
+		///
+		/// @param request_id the request id that was put into the request
+		/// @param serializer should contain serialized data, starting with the request id
+		/// @param deserializer that contains the reply after the function returns (the request id is already consumed)
 		/// @param timeout return after so many milliseconds even if the data could not be sent.
 		/// @return 0 in case of timeout, >0 in case of success, -1 in case of error
-		int atomic_send_and_receive(Serializer &serializer, Deserializer &deserializer, int timeout_ms = -1);
+		int atomic_send_and_receive(uint32_t request_id, Serializer &serializer, Deserializer &deserializer, int timeout_ms = -1);
+
+		/// @brief nobody will call receive_reply for this request id
+		///
+		/// The reply is dropped if it is already there, or as soon as it arrives.
+		/// @param request_id the request id that was put into the request
+		void discard_reply(uint32_t request_id);
+	private:
+		// these have to be called with the connection mutex locked
+		int send_request_locked(Serializer &serializer);
+		int execute_batch(Serializer &calls, unsigned num_calls);
+		int receive_reply_locked(uint32_t request_id, Deserializer &deserializer, int timeout_ms);
+		bool stash_reply(); // the fd mutex has to be locked, too
 	};
 
 
+	/// @brief The reply to a request that was sent with ClientConnection::send_request.
+	///
+	/// Used by the asynchronous calls of generated Proxy classes. If the reply was not received 
+	/// when the PendingReply is destroyed (e.g. a future was dropped without calling get()),
+	/// the ClientConnection drops the reply instead of keeping it forever.
+	/// The connection is not kept alive by the PendingReply; if it was closed before the 
+	/// reply was received (e.g. with the SignalGroup that owned it), receive throws.
+	class PendingReply {
+	public:
+		PendingReply(const std::shared_ptr<ClientConnection> &connection, uint32_t request_id);
+		~PendingReply();
+		/// @brief wait for the reply, see ClientConnection::receive_reply
+		int receive(Deserializer &deserializer, int timeout_ms = -1);
+	private:
+		PendingReply(const PendingReply&) = delete;
+		PendingReply& operator=(const PendingReply&) = delete;
+		std::weak_ptr<ClientConnection> connection;
+		uint32_t request_id;
+		bool received;
+	};
+
 	class Proxy;
 
 	/// @brief Manage incoming saftbus signals and distribute them to the connected Proxy objects.
@@ -82,11 +142,17 @@ namespace saftbus {
 	/// In some situations (e.g. when independent threads are used), Proxy objects might need their own
 	/// channel for signals. A new SignalGroup can be created and passed to the constructor of Proxy objects in order
 	/// to assign them to this SignalGroup.
+	/// By default, all Proxy objects of a process share one ClientConnection for their remote calls, and only one call 
+	/// at a time can use it. A SignalGroup can open its own ClientConnection, which is then used by all Proxy objects 
+	/// in this SignalGroup. Threads that each use their own SignalGroup of this kind don't block each other in remote calls.
+	/// Proxy objects must be destroyed before their SignalGroup.
 	class SignalGroup {
 		struct Impl; std::unique_ptr<Impl> d;
 	friend class Proxy;
 	public:
-		SignalGroup();
+		/// @param own_connection if true, the SignalGroup opens its own connection to the server for the 
+		///                       remote calls of its Proxy objects. Otherwise the connection of the process is used.
+		SignalGroup(bool own_connection = false);
 		~SignalGroup();
 
 		/// @brief used in the Constructor of Proxy objects to connect themselves to this SignalGroup.
@@ -154,9 +220,12 @@ namespace saftbus {
 		SignalGroup& get_signal_group();
 	protected:
 		Proxy(const std::string &object_path, SignalGroup &signal_group, const std::vector<std::string> &interface_names);
-		/// @brief Get the client connection. Open the connection if that didn't happen before.
-		/// @return reference to the saftbus::ClientConnection object (there is one per process).
-		static ClientConnection& get_connection();
+		/// @brief Get the client connection. This is the connection of the SignalGroup if it has one.
+		/// Otherwise it is the connection of the process, which is opened if that didn't happen before.
+		/// @return reference to the saftbus::ClientConnection object.
+		ClientConnection&        get_connection();
+		/// @brief the same connection as get_connection(), for objects that must notice when it is closed
+		std::shared_ptr<ClientConnection> get_shared_connection();
 		/// @brief Get the serializer that can be used to send data to the Service object.
 		/// @return a reference to saftbus::Serializer.
 		Serializer&              get_send();
@@ -183,6 +252,34 @@ namespace saftbus {
 		int interface_no_from_name(const std::string &interface_name); 
 	};
 
+	/// @brief Collect asynchronous Proxy calls and execute them with a single round trip.
+	///
+	/// While a Batch object exists, all asynchronous calls (the *_async functions of generated Proxy classes)
+	/// made by the same thread are not sent immediately, but collected in the Batch. They are sent as one 
+	/// message when execute is called, and the server returns all replies in one message. 
+	/// A synchronous call executes the Batch before it is sent, so that the calls keep their order. For example:
+	///
+	///     saftbus::Batch batch;
+	///     auto actions = sink->getActionCount_async();
+	///     auto late    = sink->getLateCount_async();
+	///     batch.execute();
+	///     std::cout << actions.get() << " " << late.get() << std::endl;
+	///
+	/// If get() is called on one of the futures before execute, the Batch is executed at this point.
+	/// The same happens if a call goes to another connection than the collected calls (see SignalGroup).
+	/// Remaining calls are executed by the destructor.
+	class Batch {
+		struct Impl; std::unique_ptr<Impl> d;
+	friend class ClientConnection;
+	public:
+		Batch();
+		~Batch();
+		/// @brief send all collected calls to the server and wait for the replies.
+		void execute();
+		/// @brief number of calls that were collected since the last execution
+		unsigned size();
+	};
+
 	/// @brief contains all information about the status of a saftbus server.
 	struct SaftbusInfo : public SerDesAble {
 		/// @brief contains all information about a service object
@@ -221,17 +318,23 @@ namespace saftbus {
 			pid_t process_id;
 			int client_fd;
 			std::map<int,int> signal_fds;
+			int pending_signals;
+			int dropped_signals;
 			/// @brief custom serializer
 			void serialize(Serializer &ser) const {
 				ser.put(process_id);
 				ser.put(client_fd);
 				ser.put(signal_fds);
+				ser.put(pending_signals);
+				ser.put(dropped_signals);
 			}
 			/// @brief custom deserializer
 			void deserialize(const Deserializer &des) {
 				des.get(process_id);
 				des.get(client_fd);
 				des.get(signal_fds);
+				des.get(pending_signals);
+				des.get(dropped_signals);
 			}
 		};
 		std::vector<ClientInfo> client_infos;
@@ -289,6 +392,15 @@ namespace saftbus {
 		bool remove_object(const std::string &object_path);
 		void quit();
 		SaftbusInfo get_status();
+		std::map<std::string, std::vector<uint64_t> > get_latency_histograms();
+		void set_latency_histograms(bool enable, bool reset);
+		/// @brief get duplicates of file descriptors that a Service shared with Container::set_shared_fds
+		///
+		/// The caller owns the returned file descriptors and has to close them. The call is never part
+		/// of a Batch; an active Batch is executed before the request is sent.
+		/// @param object_path the object path of the Service
+		/// @param name identifies the set of file descriptors of that object
+		std::vector<int> get_shared_fds(const std::string &object_path, const std::string &name);
 	private:
 		int interface_no;
 
@@ -1,4 +1,5 @@
 #include "configurable_chunck_allocator_rt.hpp"
+#include "loop.hpp"
 
 #include <sstream>
 
@@ -106,6 +107,10 @@ namespace saftbus
 		}
 	}
 	char* Allocator::malloc(size_t n) {
+		std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+		if (saftbus::LoopThread::any_started()) {
+			lock.lock();
+		}
 		for (size_t i = 0; i < num_allocators; ++i) {
 			if (allocators[i]->fits(n) && !allocators[i]->full()) {
 				return allocators[i]->malloc(n);
@@ -126,6 +131,10 @@ namespace saftbus
 	}
 
 	void Allocator::free(char *ptr) {
+		std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+		if (saftbus::LoopThread::any_started()) {
+			lock.lock();
+		}
 		// for (size_t i = 0; i < num_allocators; ++i) {
 		// 	allocators[i]->print_size();
 		// }
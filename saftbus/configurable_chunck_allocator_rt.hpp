@@ -8,6 +8,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstdio>
+#include <mutex>
 
 namespace saftbus
 {
@@ -43,6 +44,7 @@ private:
 	size_t num_allocators;
 	ChunckAllocatorRT **allocators;
 	size_t heap_allocations;
+	std::mutex mutex; // Services created in a saftbus::LoopThread allocate from other threads
 };
 
 // Allocator *get_allocator();
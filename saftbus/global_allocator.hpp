@@ -21,8 +21,10 @@
 #define SAFTBUS_GLOBAL_ALLOCATOR_HPP_
 
 #include "chunck_allocator_rt.hpp"
+#include "loop.hpp"
 #include <iostream>
 #include <sstream>
+#include <mutex>
 
 class Allocator {
 public:
@@ -37,6 +39,10 @@ public:
 		::free(allocator_1);
 	}
 	char* malloc(size_t n) {
+		std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+		if (saftbus::LoopThread::any_started()) {
+			lock.lock();
+		}
 		// std::cerr << "--------malloc----------" << std::endl;
 		// allocator_1->print_size();
 		// allocator_2->print_size();
@@ -53,6 +59,10 @@ public:
 		}
 	}
 	void free(char *ptr) {
+		std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+		if (saftbus::LoopThread::any_started()) {
+			lock.lock();
+		}
 					 if (allocator_1->contains(ptr)) {
 			allocator_1->free(ptr);
 		} else if (allocator_2->contains(ptr)) {
@@ -71,6 +81,7 @@ private:
 	ChunckAllocatorRT<16384,128> *allocator_1;
 	ChunckAllocatorRT<128,1024> *allocator_2;
 	ChunckAllocatorRT<64,16384> *allocator_3;
+	std::mutex mutex; // Services created in a saftbus::LoopThread allocate from other threads (only locked if there are any)
 };
 
 
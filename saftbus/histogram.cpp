@@ -0,0 +1,96 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH 
+ *
+ *  @author Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#include "histogram.hpp"
+
+#include <mutex>
+
+namespace saftbus {
+
+	std::atomic<bool> LatencyHistogram::enabled_flag(false);
+
+	// registration is rare (construction of static histograms), reading is done on request of saftbus-ctl
+	static std::mutex &registry_mutex() {
+		static std::mutex m;
+		return m;
+	}
+	static std::map<std::string, LatencyHistogram*> &registry() {
+		static std::map<std::string, LatencyHistogram*> histograms;
+		return histograms;
+	}
+
+	LatencyHistogram::LatencyHistogram(const std::string &n) 
+		: name(n)
+	{
+		reset();
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		registry()[name] = this;
+	}
+	LatencyHistogram::~LatencyHistogram() 
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		auto it = registry().find(name);
+		if (it != registry().end() && it->second == this) {
+			registry().erase(it);
+		}
+	}
+
+	void LatencyHistogram::add(std::chrono::nanoseconds duration) {
+		uint64_t ns = duration.count() > 0 ? duration.count() : 1;
+		int bin = 63 - __builtin_clzll(ns);
+		if (bin >= NUM_BINS) {
+			bin = NUM_BINS-1;
+		}
+		bins[bin].fetch_add(1, std::memory_order_relaxed);
+	}
+	std::vector<uint64_t> LatencyHistogram::get_bins() const {
+		std::vector<uint64_t> result(NUM_BINS);
+		for (int i = 0; i < NUM_BINS; ++i) {
+			result[i] = bins[i].load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+	void LatencyHistogram::reset() {
+		for (auto &bin: bins) {
+			bin.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void LatencyHistogram::enable(bool enable) {
+		enabled_flag.store(enable, std::memory_order_relaxed);
+	}
+	void LatencyHistogram::reset_all() {
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		for (auto &histogram: registry()) {
+			histogram.second->reset();
+		}
+	}
+	std::map<std::string, std::vector<uint64_t> > LatencyHistogram::get_all() {
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		std::map<std::string, std::vector<uint64_t> > result;
+		for (auto &histogram: registry()) {
+			result[histogram.first] = histogram.second->get_bins();
+		}
+		return result;
+	}
+
+	LatencyHistogram signal_serialize_latency("saftbus-signal-serialize");
+	LatencyHistogram signal_emit_latency("saftbus-signal-emit");
+}
@@ -0,0 +1,86 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH 
+ *
+ *  @author Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#ifndef SAFTBUS_HISTOGRAM_HPP_
+#define SAFTBUS_HISTOGRAM_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace saftbus {
+
+	/// @brief Lock-free histogram of durations with logarithmic bins.
+	///
+	/// Bin i counts durations d with 2^i <= d/ns < 2^(i+1) (bin 0 also counts durations below 1 ns). 
+	/// The last bin counts everything above. Recording is a relaxed atomic increment, so histograms can 
+	/// be filled from any thread on the event path. Each histogram registers itself under its name on 
+	/// construction and can be read by saftbus clients through the Container (see "saftbus-ctl --latency").
+	/// Recording is disabled by default; LatencyTimer costs a single atomic load in that case.
+	class LatencyHistogram {
+	public:
+		static const int NUM_BINS = 32;
+
+		LatencyHistogram(const std::string &name);
+		~LatencyHistogram();
+
+		void add(std::chrono::nanoseconds duration);
+		std::vector<uint64_t> get_bins() const;
+		void reset();
+
+		static bool enabled() { return enabled_flag.load(std::memory_order_relaxed); }
+		static void enable(bool enable);
+		static void reset_all();
+		/// @brief bins of all registered histograms
+		static std::map<std::string, std::vector<uint64_t> > get_all();
+	private:
+		std::string name;
+		std::atomic<uint64_t> bins[NUM_BINS];
+		static std::atomic<bool> enabled_flag;
+	};
+
+	/// @brief Measures the time from construction until stop() (or destruction) if histograms are enabled.
+	class LatencyTimer {
+	public:
+		LatencyTimer(LatencyHistogram &histogram) 
+			: hist(LatencyHistogram::enabled()?&histogram:nullptr) {
+			if (hist) start = std::chrono::steady_clock::now();
+		}
+		~LatencyTimer() { stop(); }
+		void stop() {
+			if (hist) {
+				hist->add(std::chrono::steady_clock::now() - start);
+				hist = nullptr;
+			}
+		}
+	private:
+		LatencyHistogram *hist;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	/// @brief histograms of the signal path, filled by the code that saftbus-gen generates for signals
+	extern LatencyHistogram signal_serialize_latency;
+	extern LatencyHistogram signal_emit_latency;
+}
+
+#endif
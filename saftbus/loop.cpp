@@ -29,7 +29,18 @@
 #include <cassert>
 #include <sstream>
 
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <typeinfo>
+#include <cerrno>
+
 #include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace saftbus {
 
@@ -58,7 +69,7 @@ namespace saftbus {
 		return id;
 	}
 
-	long Source::id_counter = 0;
+	std::atomic<long> Source::id_counter(0);
 
 	//////////////////////////////
 	//////////////////////////////
@@ -66,15 +77,217 @@ namespace saftbus {
 
 	struct Loop::Impl {
 		std::vector<std::unique_ptr<Source> > added_sources;
-		std::vector<std::unique_ptr<Source> > sources;
+		std::map<long, std::unique_ptr<Source> > sources; // all sources in the loop, the key is the source id
+		std::vector<std::unique_ptr<Source> > removed_sources; // sources removed during an iteration are destroyed after the iteration
 		bool running;
 		int running_depth; 
 		long id;
-		static long id_counter;
+		static std::atomic<long> id_counter;
+
+		// Sources that are neither IoSource nor TimeoutSource are asked on every iteration
+		// for their file descriptors and timeouts via the prepare/check/dispatch functions.
+		std::vector<Source*> generic_sources;
+
+		// IoSources stay registered in the epoll instance as long as they are in the loop.
+		// Several IoSources may observe the same file descriptor.
+		int epoll_fd;
+		struct FdEntry {
+			std::vector<IoSource*> io_sources;
+		};
+		std::map<int, FdEntry> fd_entries;
+		std::vector<struct epoll_event> epoll_events;
+
+		// TimeoutSources are kept in a min-heap sorted by dispatch_time.
+		// Entries of removed sources are not removed from the heap immediately, 
+		// they are discarded when they reach the top of the heap.
+		struct TimeoutEntry {
+			std::chrono::steady_clock::time_point dispatch_time;
+			long source_id;
+			bool operator<(const TimeoutEntry &rhs) const { return dispatch_time > rhs.dispatch_time; } // std::push_heap builds a max-heap
+		};
+		std::vector<TimeoutEntry> timeouts;
+		unsigned timeout_sources; // number of TimeoutSources in the loop
+
+		// Lists of sources that are selected for dispatching in the (possibly nested) iterations.
+		// Removed sources are replaced by nullptr in these lists.
+		std::vector<std::vector<Source*>*> dispatch_lists;
+
+		void register_source(Source *source);
+		void unregister_source(Source *source);
+		void update_fd(int fd);
+		void push_timeout(TimeoutSource *source);
+		TimeoutSource *top_timeout(); // returns nullptr if there are no timeouts
+		void compact_timeouts();
+		void remove(long source_id);
+
+		// Work passed from other threads with invoke and invoke_and_wait, in one queue so that it 
+		// is executed in the order in which it was passed. 
+		// The eventfd is registered in the epoll instance and wakes up the loop.
+		struct InvokedWork {
+			std::function<void()> work;
+			bool waited; // passed with invoke_and_wait, the caller waits for it
+		};
+		int invoke_fd;
+		std::mutex invoke_mutex;
+		std::deque<InvokedWork> invoked;
+		void wake_up();
+		void run_invoked(bool only_waited);
 	};
-	long Loop::Impl::id_counter = 0;
+	std::atomic<long> Loop::Impl::id_counter(0);
+
+	// the Loop of a LoopThread, nullptr in all other threads
+	static thread_local Loop *thread_loop = nullptr;
+
+	void Loop::Impl::wake_up() {
+		uint64_t one = 1;
+		if (write(invoke_fd, &one, sizeof(one)) != sizeof(one)) {
+			std::cerr << "saftbus::Loop cannot write to eventfd: " << strerror(errno) << std::endl;
+		}
+	}
+
+	// only_waited is used by a thread that waits in invoke_and_wait: it runs only the work other 
+	// threads wait for (otherwise they might wait for each other), the rest stays in the queue
+	void Loop::Impl::run_invoked(bool only_waited) {
+		for (;;) {
+			std::function<void()> work;
+			{
+				std::lock_guard<std::mutex> lock(invoke_mutex);
+				auto next = invoked.begin();
+				if (only_waited) {
+					while (next != invoked.end() && !next->waited) ++next;
+				}
+				if (next == invoked.end()) {
+					return;
+				}
+				work = std::move(next->work);
+				invoked.erase(next);
+			}
+			work();
+		}
+	}
+
+	void Loop::Impl::register_source(Source *source) {
+		if (typeid(*source) == typeid(IoSource)) {
+			IoSource *io_source = static_cast<IoSource*>(source);
+			fd_entries[io_source->pfd.fd].io_sources.push_back(io_source);
+			update_fd(io_source->pfd.fd);
+		} else if (typeid(*source) == typeid(TimeoutSource)) {
+			++timeout_sources;
+			push_timeout(static_cast<TimeoutSource*>(source));
+		} else {
+			generic_sources.push_back(source);
+		}
+	}
+
+	void Loop::Impl::unregister_source(Source *source) {
+		for (auto &list: dispatch_lists) {
+			std::replace(list->begin(), list->end(), source, static_cast<Source*>(nullptr));
+		}
+		if (typeid(*source) == typeid(IoSource)) {
+			IoSource *io_source = static_cast<IoSource*>(source);
+			auto entry = fd_entries.find(io_source->pfd.fd);
+			if (entry != fd_entries.end()) {
+				auto &io_sources = entry->second.io_sources;
+				io_sources.erase(std::remove(io_sources.begin(), io_sources.end(), io_source), io_sources.end());
+				update_fd(io_source->pfd.fd);
+			}
+		} else if (typeid(*source) == typeid(TimeoutSource)) {
+			// the heap entry is discarded when it reaches the top of the heap
+			--timeout_sources;
+			compact_timeouts();
+		} else {
+			std::replace(generic_sources.begin(), generic_sources.end(), source, static_cast<Source*>(nullptr));
+		}
+	}
+
+	// bring the epoll registration of fd in line with the IoSources that observe it
+	void Loop::Impl::update_fd(int fd) {
+		auto entry = fd_entries.find(fd);
+		if (entry == fd_entries.end()) {
+			return;
+		}
+		if (entry->second.io_sources.empty()) {
+			epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr); // fails if fd was already closed, which is fine
+			fd_entries.erase(entry);
+			return;
+		}
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.data.fd = fd;
+		for (auto &io_source: entry->second.io_sources) {
+			event.events |= io_source->pfd.events; // POLLIN,POLLOUT,POLLERR,POLLHUP have the same values as their EPOLL* counterparts
+		}
+		// A closed file descriptor is silently removed from the epoll instance and its number may 
+		// be reused for a new file descriptor => try both ADD and MOD.
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0 && errno == ENOENT) {
+			if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+				std::cerr << "saftbus::Loop cannot add fd " << fd << " to epoll: " << strerror(errno) << std::endl;
+			}
+		}
+	}
+
+	void Loop::Impl::push_timeout(TimeoutSource *source) {
+		TimeoutEntry entry;
+		entry.dispatch_time = source->dispatch_time;
+		entry.source_id     = source->get_id();
+		timeouts.push_back(entry);
+		std::push_heap(timeouts.begin(), timeouts.end());
+	}
+
+	TimeoutSource *Loop::Impl::top_timeout() {
+		while (!timeouts.empty()) {
+			auto source = sources.find(timeouts.front().source_id);
+			if (source != sources.end()) {
+				TimeoutSource *timeout_source = static_cast<TimeoutSource*>(source->second.get());
+				if (timeout_source->dispatch_time == timeouts.front().dispatch_time) {
+					return timeout_source;
+				}
+			}
+			// discard entries of removed sources
+			std::pop_heap(timeouts.begin(), timeouts.end());
+			timeouts.pop_back();
+		}
+		return nullptr;
+	}
+
+	// prevent the heap from growing if TimeoutSources are frequently removed before they expire
+	void Loop::Impl::compact_timeouts() {
+		if (timeouts.size() < 2*timeout_sources + 64) {
+			return;
+		}
+		timeouts.erase(std::remove_if(timeouts.begin(), timeouts.end(), [this](const TimeoutEntry &entry) {
+				auto source = sources.find(entry.source_id);
+				return source == sources.end() 
+				    || !source->second
+				    || static_cast<TimeoutSource*>(source->second.get())->dispatch_time != entry.dispatch_time;
+			}), timeouts.end());
+		std::make_heap(timeouts.begin(), timeouts.end());
+	}
 
+	void Loop::Impl::remove(long source_id) {
+		auto source = sources.find(source_id);
+		if (source != sources.end()) {
+			std::unique_ptr<Source> removed = std::move(source->second);
+			sources.erase(source);
+			unregister_source(removed.get());
+			if (running_depth) {
+				// the source may be the one that is currently dispatched
+				removed_sources.push_back(std::move(removed));
+			}
+		}
+	}
 	
+	// poll with nanosecond resolution. A negative timeout means: wait forever
+	static int poll_ns(struct pollfd *pfds, nfds_t nfds, std::chrono::nanoseconds timeout) {
+		if (timeout.count() < 0) {
+			return ppoll(pfds, nfds, nullptr, nullptr);
+		}
+		struct timespec ts;
+		ts.tv_sec  = timeout.count() / 1000000000;
+		ts.tv_nsec = timeout.count() % 1000000000;
+		return ppoll(pfds, nfds, &ts, nullptr);
+	}
+
 	Loop::Loop() 
 		: d(new Impl)
 	{
@@ -82,28 +295,105 @@ namespace saftbus {
 		// dynamic allocation in normal operation
 		const size_t revserve_that_much = 32;
 		d->added_sources.reserve(revserve_that_much);
-		d->sources.reserve(revserve_that_much);
+		d->removed_sources.reserve(revserve_that_much);
+		d->generic_sources.reserve(revserve_that_much);
+		d->timeouts.reserve(revserve_that_much);
+		d->epoll_events.resize(revserve_that_much);
+		d->timeout_sources = 0;
 		d->running = true;
 		d->running_depth = 0; // 0 means: the loop is not running
 		if (d->id_counter == -1) ++d->id_counter; // prevent d->id_counter to produce an id of 0 (no source should have id 0)
 		d->id = ++d->id_counter;
 		d->id |= ((long)rand()%0xffffffff)<<32;
+		d->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		if (d->epoll_fd < 0) {
+			std::cerr << "saftbus::Loop cannot create epoll instance: " << strerror(errno) << std::endl;
+		}
+		d->invoke_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		struct epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events  = EPOLLIN;
+		event.data.fd = d->invoke_fd;
+		if (d->invoke_fd < 0 || epoll_ctl(d->epoll_fd, EPOLL_CTL_ADD, d->invoke_fd, &event) < 0) {
+			std::cerr << "saftbus::Loop cannot create eventfd: " << strerror(errno) << std::endl;
+		}
 	}
 	Loop::~Loop() {
-		d->sources.clear();
-		d->added_sources.clear();
+		clear();
+		close(d->invoke_fd);
+		close(d->epoll_fd);
 	}
 
 	Loop& Loop::get_default() {
 		static Loop default_loop;
+		if (thread_loop) {
+			return *thread_loop;
+		}
 		return default_loop;
 	}
 
+	void Loop::invoke(std::function<void()> work) {
+		{
+			std::lock_guard<std::mutex> lock(d->invoke_mutex);
+			d->invoked.push_back(Impl::InvokedWork{std::move(work), false});
+		}
+		d->wake_up();
+	}
+
+	void Loop::invoke_and_wait(std::function<void()> work) {
+		Loop &caller = get_default();
+		if (&caller == this) {
+			work();
+			return;
+		}
+		std::atomic<bool> done(false);
+		std::exception_ptr error;
+		{
+			std::lock_guard<std::mutex> lock(d->invoke_mutex);
+			d->invoked.push_back(Impl::InvokedWork{[&]() {
+				try {
+					work();
+				} catch (...) {
+					error = std::current_exception();
+				}
+				done = true;
+				caller.d->wake_up();
+			}, true});
+		}
+		d->wake_up();
+		while (!done) {
+			struct pollfd pfd;
+			pfd.fd      = caller.d->invoke_fd;
+			pfd.events  = POLLIN;
+			pfd.revents = 0;
+			if (poll(&pfd, 1, -1) > 0) {
+				uint64_t count;
+				if (read(caller.d->invoke_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+					std::cerr << "saftbus::Loop cannot read from eventfd: " << strerror(errno) << std::endl;
+				}
+			}
+			// the other thread may need this thread to complete the work
+			caller.d->run_invoked(true);
+		}
+		{
+			// the wake-up for work that was invoked meanwhile was consumed above
+			std::lock_guard<std::mutex> lock(caller.d->invoke_mutex);
+			if (!caller.d->invoked.empty()) {
+				caller.d->wake_up();
+			}
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
 	bool Loop::iteration(bool may_block) {
 		++d->running_depth;
-		static const auto no_timeout = std::chrono::milliseconds(-1);
+		static const auto no_timeout = std::chrono::nanoseconds(-1);
 		std::vector<struct pollfd> pfds;
 		std::vector<struct pollfd*> source_pfds;
+		std::vector<Source*> ready_sources; // IoSources and generic sources with a ready file descriptor
+		d->dispatch_lists.push_back(&ready_sources);
 		auto timeout = no_timeout; 
 
 		// unsigned us = 0;
@@ -114,16 +404,22 @@ namespace saftbus {
 		// preparation 
 		// (find the earliest timeout)
 		//////////////////
-		for(auto &source: d->sources) {
+		TimeoutSource *first_timeout = d->top_timeout();
+		if (first_timeout) {
+			timeout = std::max(std::chrono::nanoseconds(0), 
+			                   std::chrono::duration_cast<std::chrono::nanoseconds>(first_timeout->dispatch_time - std::chrono::steady_clock::now()));
+		}
+		for(unsigned i = 0; i < d->generic_sources.size(); ++i) {
+			Source *source = d->generic_sources[i];
 			if (!source) continue; 
 
-			auto timeout_from_source = no_timeout;
+			auto timeout_from_source = std::chrono::milliseconds(-1);
 			source->prepare(timeout_from_source); // source may leave timeout_from_source unchanged 
-			if (timeout_from_source != no_timeout) {
+			if (timeout_from_source.count() >= 0) {
 				if (timeout == no_timeout) {
 					timeout = timeout_from_source;
 				} else {
-					timeout = std::min(timeout, timeout_from_source);
+					timeout = std::min<std::chrono::nanoseconds>(timeout, timeout_from_source);
 				}
 			}
 			for(auto it = source->pfds.cbegin(); it != source->pfds.cbegin()+source->pfds.size(); ++it) {
@@ -134,19 +430,34 @@ namespace saftbus {
 			}
 		}
 		if (!may_block) { 
-			timeout = std::chrono::milliseconds(0);
+			timeout = std::chrono::nanoseconds(0);
+		}
+		if (d->sources.empty() && d->added_sources.empty() && thread_loop != this) {
+			// A loop without sources has nothing to wait for, return right away (Loop::run will stop).
+			// Only the loop of a LoopThread keeps waiting on the eventfd for invoked work.
+			timeout = std::chrono::nanoseconds(0);
 		}
 		//////////////////
 		// polling / waiting
 		//////////////////
+		int epoll_result = 0;
 		if (pfds.size() > 0) {
+			// The epoll instance is itself a file descriptor that can be polled together with the generic sources
+			struct pollfd epoll_pfd;
+			epoll_pfd.fd      = d->epoll_fd;
+			epoll_pfd.events  = POLLIN;
+			epoll_pfd.revents = 0;
+			pfds.push_back(epoll_pfd);
 			// std::cerr << "polling timeout_ms = " << timeout.count() << std::endl;
 			int poll_result = 0;
-			if ((poll_result = poll(&pfds[0], pfds.size(), timeout.count())) > 0) {
+			if ((poll_result = poll_ns(&pfds[0], pfds.size(), timeout)) > 0) {
 				// copy the results back to the owners of the pfds
-				for (unsigned i = 0; i < pfds.size();++i) {
+				for (unsigned i = 0; i < source_pfds.size();++i) {
 					source_pfds[i]->revents = pfds[i].revents;
 				}
+				if (pfds.back().revents & POLLIN) {
+					epoll_result = epoll_wait(d->epoll_fd, &d->epoll_events[0], d->epoll_events.size(), 0);
+				}
 			} else if (poll_result < 0) {
 				// std::cerr << "poll error: " << strerror(errno) << std::endl;
 			} else {
@@ -154,24 +465,75 @@ namespace saftbus {
 			}
 			start = std::chrono::steady_clock::now();
 
-		} else if (timeout > std::chrono::milliseconds(0)) {
-			std::this_thread::sleep_for(timeout);
+		} else {
+			// the epoll instance always contains at least the eventfd for invoked work
+			if (timeout.count() < 0 || timeout.count() % 1000000 == 0) { // epoll_wait has millisecond resolution 
+				// no_timeout (-1 ns) would be truncated to 0 ms by duration_cast
+				int timeout_ms = timeout.count() < 0 ? -1 : std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count();
+				epoll_result = epoll_wait(d->epoll_fd, &d->epoll_events[0], d->epoll_events.size(), timeout_ms);
+			} else {
+				struct pollfd epoll_pfd;
+				epoll_pfd.fd      = d->epoll_fd;
+				epoll_pfd.events  = POLLIN;
+				epoll_pfd.revents = 0;
+				if (poll_ns(&epoll_pfd, 1, timeout) > 0) {
+					epoll_result = epoll_wait(d->epoll_fd, &d->epoll_events[0], d->epoll_events.size(), 0);
+				}
+			}
 			start = std::chrono::steady_clock::now();
-			
 		}
 
 		//////////////////
 		// dispatching
 		//////////////////
-		for (auto &source: d->sources) {
-			if (!source) continue;
+		// only IoSources with ready file descriptors are looked at
+		for (int i = 0; i < epoll_result; ++i) {
+			if (d->epoll_events[i].data.fd == d->invoke_fd) {
+				uint64_t count;
+				if (read(d->invoke_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+					std::cerr << "saftbus::Loop cannot read from eventfd: " << strerror(errno) << std::endl;
+				}
+				d->run_invoked(false);
+				continue;
+			}
+			auto entry = d->fd_entries.find(d->epoll_events[i].data.fd);
+			if (entry == d->fd_entries.end()) continue;
+			for (auto &io_source: entry->second.io_sources) {
+				if (d->epoll_events[i].events & io_source->pfd.events) {
+					io_source->pfd.revents = d->epoll_events[i].events;
+					ready_sources.push_back(io_source);
+				}
+			}
+		}
+		if (epoll_result == static_cast<int>(d->epoll_events.size())) {
+			// there might be more ready file descriptors than fit into the buffer
+			d->epoll_events.resize(2*d->epoll_events.size());
+		}
+		for (auto &source: d->generic_sources) {
+			if (source) ready_sources.push_back(source); // generic sources decide in check() if they are ready
+		}
+		for (auto &source: ready_sources) {
+			if (!source) continue; // removed while dispatching another source
 
 			if (source->check()) { // if check returns true, dispatch is called
 				if (!source->dispatch()) { // if dispatch returns false, the source is removed
-					source.reset();
+					if (source) d->remove(source->get_id());
 				}
 			}
 		}
+		// only TimeoutSources that are due are looked at
+		while ((first_timeout = d->top_timeout()) != nullptr && first_timeout->check()) {
+			long id = first_timeout->get_id();
+			std::pop_heap(d->timeouts.begin(), d->timeouts.end());
+			d->timeouts.pop_back();
+			if (!first_timeout->dispatch()) { // if dispatch returns false, the source is removed
+				d->remove(id);
+			} else if (d->sources.find(id) != d->sources.end()) { // the source might have removed itself
+				d->push_timeout(first_timeout);
+			}
+		}
+
+		d->dispatch_lists.pop_back();
 
 		//////////////////////////////////////////////////////
 		// cleanup of finished sources
@@ -180,13 +542,16 @@ namespace saftbus {
 		//////////////////////////////////////////////////////
 		if (d->running_depth == 1) {
 			// std::cerr << "cleaning up sources" << d->sources.size() << std::endl;
-			d->sources.erase(std::remove_if(d->sources.begin(), d->sources.end(), [](std::unique_ptr<Source> &s){return !s;}), 
-				          d->sources.end());
+			d->removed_sources.clear();
+			d->generic_sources.erase(std::remove(d->generic_sources.begin(), d->generic_sources.end(), static_cast<Source*>(nullptr)), 
+				          d->generic_sources.end());
 
 			// adding new sources
 			for (auto &added_source: d->added_sources) {
 				if (added_source) {
-					d->sources.push_back(std::move(added_source));
+					Source *source = added_source.get();
+					d->sources[source->get_id()] = std::move(added_source);
+					d->register_source(source);
 				}
 			}
 			d->added_sources.clear();
@@ -231,7 +596,9 @@ namespace saftbus {
 			// the source vector after the iteration is done
 			d->added_sources.push_back(std::move(source));
 		} else {
-			d->sources.push_back(std::move(source));
+			Source *s = source.get();
+			d->sources[s->id] = std::move(source);
+			d->register_source(s);
 		}
 		return result;
 	}
@@ -244,11 +611,8 @@ namespace saftbus {
 	/// @param s the source handle returned from the connect method
 	void Loop::remove(SourceHandle s) {
 		if (s.loop_id == d->id) { // make sure s was connected to this loop
-			auto source = d->sources.begin();
-			if ((source=std::find(source, d->sources.end(), s)) != d->sources.end()) {
-				source->reset();
-			}
-			source = d->added_sources.begin();
+			d->remove(s.source_id);
+			auto source = d->added_sources.begin();
 			if ((source=std::find(source, d->added_sources.end(), s)) != d->added_sources.end()) {
 				source->reset();
 			}
@@ -256,7 +620,9 @@ namespace saftbus {
 	}
 
 	void Loop::clear() {
-		d->sources.clear();
+		while (!d->sources.empty()) {
+			d->remove(d->sources.begin()->first);
+		}
 		d->added_sources.clear();
 	}
 
@@ -266,17 +632,17 @@ namespace saftbus {
 	//////////////////////////////
 
 
-	TimeoutSource::TimeoutSource(std::function<bool(void)> s, std::chrono::milliseconds i, std::chrono::milliseconds o) 
+	TimeoutSource::TimeoutSource(std::function<bool(void)> s, std::chrono::nanoseconds i, std::chrono::nanoseconds o) 
 		: slot(s), interval(i), dispatch_time(std::chrono::steady_clock::now()+o)
 	{
-		if (interval <= std::chrono::milliseconds(0)) {
+		if (interval <= std::chrono::nanoseconds(0)) {
 			interval = std::chrono::milliseconds(1);
 		}
 	}
-	TimeoutSource::TimeoutSource(std::function<bool(void)> s, std::chrono::milliseconds i) 
+	TimeoutSource::TimeoutSource(std::function<bool(void)> s, std::chrono::nanoseconds i) 
 		: slot(s), interval(i), dispatch_time(std::chrono::steady_clock::now()+i)
 	{
-		if (interval <= std::chrono::milliseconds(0)) {
+		if (interval <= std::chrono::nanoseconds(0)) {
 			interval = std::chrono::milliseconds(1);
 		}
 	}
@@ -299,12 +665,7 @@ namespace saftbus {
 	// After the wait phase, the loop will call check on all source.
 	// Loop will call dispatch on all sources where check returns true. 
 	bool TimeoutSource::check() {
-		auto now = std::chrono::steady_clock::now();
-		auto timeout_ms = std::chrono::duration_cast<std::chrono::milliseconds>(dispatch_time - now); 
-		if (timeout_ms.count() <= 0) {
-			return true;
-		}
-		return false;
+		return dispatch_time <= std::chrono::steady_clock::now();
 	}
 
 	// Execute whatever action is attached to the source
@@ -371,4 +732,47 @@ namespace saftbus {
 		return result.str();
 	}
 
+	//////////////////////////////
+	//////////////////////////////
+	//////////////////////////////
+
+	struct LoopThread::Impl {
+		Loop loop;
+		bool stop; // only accessed in the thread
+		std::thread thread;
+		void run() {
+			thread_loop = &loop;
+			// unlike Loop::run, this does not return if the loop has no sources
+			while (!stop) {
+				loop.iteration(true);
+			}
+			loop.clear(); // Sources are destroyed in the thread that used them
+		}
+	};
+
+	static std::atomic<bool> loop_thread_started(false);
+
+	LoopThread::LoopThread() 
+		: d(new Impl)
+	{
+		d->stop = false;
+		loop_thread_started = true; // before the thread exists, so that the thread sees it too
+		d->thread = std::thread(&LoopThread::Impl::run, d.get());
+	}
+
+	LoopThread::~LoopThread() 
+	{
+		Impl *impl = d.get();
+		d->loop.invoke([impl]() { impl->stop = true; });
+		d->thread.join();
+	}
+
+	Loop &LoopThread::get_loop() {
+		return d->loop;
+	}
+
+	bool LoopThread::any_started() {
+		return loop_thread_started.load(std::memory_order_acquire);
+	}
+
 }
\ No newline at end of file
@@ -27,6 +27,7 @@
 #include <functional>
 #include <vector>
 #include <set>
+#include <atomic>
 
 #include <poll.h>
 
@@ -52,7 +53,7 @@ namespace saftbus {
 	private:
 		Loop *loop;
 		std::vector<pollfd*> pfds;
-		static long id_counter;
+		static std::atomic<long> id_counter;
 		long id; 
 	};
 	/// @brief unique identifier for an event source in a saftbus::Loop
@@ -69,12 +70,16 @@ namespace saftbus {
 
 	/// @brief an event loop, driven by Sources
 	/// 
+	/// IoSources are registered in an epoll instance as long as they are connected
+	/// and TimeoutSources are kept in a min-heap ordered by their dispatch time.
+	/// All other Sources are asked for their file descriptors and timeouts on every iteration.
+	///
 	/// One loop iteration goes like this:
-	///   * find earliest timeout from all sources by calling the Source::prepare function
-	///   * collect all source file descriptors that need to be polled
-	///   * in case there are any file descriptors, do the poll system call
-	///   * in case there are no file descriptors, wait until the earliest timeout
-	///   * call Source::dispatch for all sources where Source::check returns true.
+	///   * find earliest timeout from the first TimeoutSource and from all other sources by calling the Source::prepare function
+	///   * collect all file descriptors of other sources that need to be polled
+	///   * in case there are any, poll them together with the epoll file descriptor
+	///   * otherwise wait on the epoll file descriptor (if any IoSource is connected) or until the earliest timeout
+	///   * call Source::dispatch for ready IoSources, due TimeoutSources, and other sources where Source::check returns true.
 	class Loop {
 		struct Impl; std::unique_ptr<Impl> d;
 	public:
@@ -92,9 +97,47 @@ namespace saftbus {
 		}
 		void remove(SourceHandle s);
 		void clear(); // remove all sources
+
+		/// @brief execute work in the thread that runs this Loop. 
+		///
+		/// This is the only Loop function that may be called from any thread.
+		/// Work passed with invoke and invoke_and_wait is executed in the order in which it was passed.
+		void invoke(std::function<void()> work);
+
+		/// @brief execute work in the thread that runs this Loop and wait until it is done.
+		///
+		/// Exceptions thrown by work are rethrown in the calling thread. 
+		/// If called from the thread of this Loop, work is executed immediately.
+		/// While waiting, the calling thread executes the work that is passed to its own Loop 
+		/// with invoke_and_wait, ahead of work passed with invoke. Two threads can therefore call 
+		/// each other without deadlock.
+		/// The calling thread must be the thread of a Loop (i.e. the main thread or a LoopThread).
+		void invoke_and_wait(std::function<void()> work);
+
+		/// @brief the Loop of the calling thread.
+		///
+		/// In a LoopThread this is the Loop of that thread, in all other threads it is the process-wide default Loop.
 		static Loop &get_default();
 	};
 
+	/// @brief A Loop that runs in its own thread.
+	///
+	/// Inside of the thread, Loop::get_default() returns the Loop of the thread, so that 
+	/// all Sources created by code that runs in the thread are attached to it.
+	/// Other threads pass work to the thread using get_loop().invoke() or get_loop().invoke_and_wait().
+	class LoopThread {
+		struct Impl; std::unique_ptr<Impl> d;
+	public:
+		LoopThread();
+		/// @brief stop the Loop and wait for the thread to finish
+		~LoopThread();
+		Loop &get_loop();
+		/// @brief true once the first LoopThread of the process was created (it stays true).
+		///
+		/// Until then a process that uses no other threads can skip locking, e.g. in the allocator of saftbusd.
+		static bool any_started();
+	};
+
     /////////////////////////////////////
 	// Define two useful Source types
     /////////////////////////////////////
@@ -104,21 +147,24 @@ namespace saftbus {
 	/// The source is removed whenever the connected function returns false.
 	class TimeoutSource : public Source {
 	public:
+		/// Intervals and offsets can be given with any std::chrono::duration type (e.g. std::chrono::milliseconds or 
+		/// std::chrono::microseconds), the loop resolves them with nanosecond precision.
 		/// @param slot the function that is called periodically. 
-		/// @param interval duration between calls to slot. If interval is smaller than 1 ms, it is set to 1 ms.
+		/// @param interval duration between calls to slot. If interval is not positive, it is set to 1 ms.
 		/// @param offset   fist execution starts after waiting for offset amount of time.
-		TimeoutSource(std::function<bool(void)> slot, std::chrono::milliseconds interval, std::chrono::milliseconds offset);
-		/// @param slot the function that is called periodically. If interval is smaller than 1 ms, it is set to 1 ms.
+		TimeoutSource(std::function<bool(void)> slot, std::chrono::nanoseconds interval, std::chrono::nanoseconds offset);
+		/// @param slot the function that is called periodically. If interval is not positive, it is set to 1 ms.
 		/// @param interval duration between calls to slot, fist execution starts at after waiting one interval worth of time.
-		TimeoutSource(std::function<bool(void)> slot, std::chrono::milliseconds interval);
+		TimeoutSource(std::function<bool(void)> slot, std::chrono::nanoseconds interval);
 		~TimeoutSource();
 		bool prepare(std::chrono::milliseconds &timeout_ms) override;
 		bool check() override;
 		bool dispatch() override;
 		std::string type() override;
 	private:
+		friend class Loop;
 		std::function<bool(void)> slot;
-		std::chrono::milliseconds interval;
+		std::chrono::nanoseconds interval;
 		std::chrono::time_point<std::chrono::steady_clock> dispatch_time;		
 	};
 
@@ -21,6 +21,7 @@
 #include "client.hpp"
 
 #include <iostream>
+#include <iomanip>
 #include <sstream>
 #include <algorithm>
 #include <thread>
@@ -29,7 +30,7 @@
 void usage(char *argv0) {
 		std::cout << "saftbus-ctl version " << VERSION << std::endl;
 		std::cout << std::endl;
-		std::cout << "usage: " << argv0 << " [-s] [-r <object-path>] [-l <plugin.so> {plugin-args}] [-u <plugin.so>] [-h|--help]" << std::endl;
+		std::cout << "usage: " << argv0 << " [-s] [-r <object-path>] [-l <plugin.so> {plugin-args}] [-u <plugin.so>] [--latency [enable|disable|reset]] [-h|--help]" << std::endl;
 		std::cout << std::endl;
 		std::cout << "  -s           print saftbus status, i.e. all available services," << std::endl; 
 		std::cout << "               loaded plugins and connected clients." << std::endl;
@@ -45,6 +46,11 @@ void usage(char *argv0) {
 		std::cout << "  -u           unload plugin. This should only be done when no services" << std::endl;
 		std::cout << "               that were created from code within that plugin are active." << std::endl;
 		std::cout << std::endl;
+		std::cout << "  --latency [enable|disable|reset]" << std::endl;
+		std::cout << "               print the latency histograms of saftbusd. With an argument," << std::endl;
+		std::cout << "               start or stop recording, or clear the histograms and restart recording." << std::endl;
+		std::cout << "               Recording is disabled when saftbusd starts." << std::endl;
+		std::cout << std::endl;
 		std::cout << "  -q           cause saftbusd to quit" << std::endl;
 		std::cout << std::endl;
 		std::cout << "  -h | --help  print help and exit" << std::endl;
@@ -96,7 +102,11 @@ void print_status(saftbus::SaftbusInfo &saftbus_info) {
 	std::cout << std::endl;
 	std::cout << "connected client processes:" << std::endl;
 	for (auto &client: saftbus_info.client_infos) {
-		std::cout << "  " << client.client_fd << " (pid=" << client.process_id << ")" << std::endl;
+		std::cout << "  " << client.client_fd << " (pid=" << client.process_id << ")";
+		if (client.pending_signals || client.dropped_signals) {
+			std::cout << " pending-signals=" << client.pending_signals << " dropped-signals=" << client.dropped_signals;
+		}
+		std::cout << std::endl;
 	}
 
 	for (auto &additional: saftbus_info.additional_info) {
@@ -114,6 +124,47 @@ void print_status(saftbus::SaftbusInfo &saftbus_info) {
 }
 
 
+// print a duration in ns with a reasonable unit
+std::string format_ns(uint64_t ns) {
+	std::ostringstream out;
+	if      (ns < 1000)       out << ns << "ns";
+	else if (ns < 1000000)    out << ns/1000 << "us";
+	else if (ns < 1000000000) out << ns/1000000 << "ms";
+	else                      out << ns/1000000000 << "s";
+	return out.str();
+}
+
+// bin i of a LatencyHistogram counts durations in [2^i,2^(i+1)) ns.
+// Percentiles are reported as the upper edge of the bin in which they are found.
+void print_latency_histograms(const std::map<std::string, std::vector<uint64_t> > &histograms) {
+	for (auto &histogram: histograms) {
+		auto &bins = histogram.second;
+		uint64_t count = 0;
+		for (auto &bin: bins) count += bin;
+		std::cout << histogram.first << ": count=" << count;
+		if (count) {
+			const double percentiles[] = {0.5, 0.99, 0.999};
+			const char  *names[]       = {"p50", "p99", "p99.9"};
+			for (int p = 0; p < 3; ++p) {
+				uint64_t sum = 0;
+				for (unsigned i = 0; i < bins.size(); ++i) {
+					sum += bins[i];
+					if (sum >= percentiles[p]*count) {
+						std::cout << " " << names[p] << "<" << format_ns(uint64_t(2)<<i);
+						break;
+					}
+				}
+			}
+		}
+		std::cout << std::endl;
+		for (unsigned i = 0; i < bins.size(); ++i) {
+			if (bins[i]) {
+				std::cout << "  " << std::setw(6) << format_ns(uint64_t(1)<<i) << " .. " << std::setw(6) << format_ns(uint64_t(2)<<i) << " : " << bins[i] << std::endl;
+			}
+		}
+	}
+}
+
 int main(int argc, char **argv)
 {
 	try {
@@ -150,6 +201,19 @@ int main(int argc, char **argv)
 					print_status(saftbus_info);
 					return 0;
 				}
+				if (argvi == "--latency") {
+					auto container_proxy = saftbus::Container_Proxy::create();
+					if ((i+1) < argc) {
+						std::string cmd(argv[++i]);
+						if      (cmd == "enable")  container_proxy->set_latency_histograms(true, false);
+						else if (cmd == "disable") container_proxy->set_latency_histograms(false, false);
+						else if (cmd == "reset")   container_proxy->set_latency_histograms(true, true);
+						else throw std::runtime_error("expect enable, disable, or reset after --latency");
+						return 0;
+					}
+					print_latency_histograms(container_proxy->get_latency_histograms());
+					return 0;
+				}
 				if (argvi == "-l") {
 					if ((++i) < argc) {
 						std::string so_filename = argv[i];
@@ -22,10 +22,19 @@
 
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <climits>
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/un.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -37,7 +46,7 @@
 
 namespace saftbus {
 
-	int write_all(int fd, const char *buffer, int size)
+	int write_all(int fd, const char *buffer, int size, const WaitWritable &wait_writable)
 	{
 		const char *ptr = buffer;
 		int written_total = 0;
@@ -45,8 +54,11 @@ namespace saftbus {
 			// calls to write are limited to 100 kB 
 			// to avoid "message too long error" 
 			// larger buffers are split into multiple calls to ::write
-			int size_chunk = std::min(size,100000); 
+			int size_chunk = std::min(size,max_record_size); 
 			int written_chunk = 0;
+			if (wait_writable) {
+				wait_writable(fd);
+			}
 			do {
 				int result = ::write(fd, ptr, size_chunk-written_chunk);
 				if (result > 0)	{
@@ -80,24 +92,153 @@ namespace saftbus {
 		return read_total;
 	}
 
-	bool Serializer::write_to(int fd) {
-		bool result = write_to_no_init(fd);
+	// The BulkBuffer region starts with a header, the message follows at bulk_data_offset
+	struct BulkHeader {
+		std::atomic<uint32_t> busy; // 1 while the region contains a message that was not yet read
+	};
+	static const size_t bulk_data_offset = 64;
+
+	struct BulkBuffer::Impl {
+		int fd;
+		char *region;
+		size_t mapped_size;
+		BulkHeader *header() { return reinterpret_cast<BulkHeader*>(region); }
+		// make sure that at least size bytes of the region are mapped
+		bool map(size_t size) {
+			if (size <= mapped_size) {
+				return true;
+			}
+			void *new_region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (new_region == MAP_FAILED) {
+				return false;
+			}
+			if (region != nullptr) {
+				munmap(region, mapped_size);
+			}
+			region      = static_cast<char*>(new_region);
+			mapped_size = size;
+			return true;
+		}
+	};
+
+	BulkBuffer::BulkBuffer(int fd) 
+		: d(new Impl)
+	{
+		d->fd          = fd;
+		d->region      = nullptr;
+		d->mapped_size = 0;
+	}
+	BulkBuffer::~BulkBuffer()
+	{
+		if (d->region != nullptr) {
+			munmap(d->region, d->mapped_size);
+		}
+		close(d->fd);
+	}
+	int BulkBuffer::create()
+	{
+		int fd = memfd_create("saftbus-bulk", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+		if (fd == -1) {
+			return -1;
+		}
+		// the region may only grow, so that a mapped region never loses its backing pages (SIGBUS)
+		if (ftruncate(fd, bulk_data_offset) != 0 || // the header is zero-initialized, i.e. not busy
+			fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL) != 0) {
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+	int BulkBuffer::get_fd() const 
+	{
+		return d->fd;
+	}
+	bool BulkBuffer::put(const std::vector<char> &data)
+	{
+		if (!d->map(bulk_data_offset)) {
+			return false;
+		}
+		uint32_t not_busy = 0;
+		if (!d->header()->busy.compare_exchange_strong(not_busy, 1)) {
+			return false; // the previous message was not yet read by the other side
+		}
+		size_t needed = bulk_data_offset + data.size();
+		if (needed > d->mapped_size) {
+			// grow the region, but never shrink it (the other side may have grown it already)
+			size_t new_size = d->mapped_size;
+			while (new_size < needed) {
+				new_size *= 2;
+			}
+			struct stat st;
+			if (fstat(d->fd, &st) != 0 || 
+				((size_t)st.st_size < new_size && ftruncate(d->fd, new_size) != 0) || 
+				!d->map(new_size)) {
+				d->header()->busy = 0;
+				return false;
+			}
+		}
+		memcpy(d->region + bulk_data_offset, data.data(), data.size());
+		return true;
+	}
+	bool BulkBuffer::get(std::vector<char> &data, int size)
+	{
+		// the size comes from the other side of the connection. Don't read beyond the end 
+		// of the file, and refuse a region that could be shrunk while it is read.
+		if (size < 0 || size > bulk_max_size) {
+			return false;
+		}
+		struct stat st;
+		int seals = fcntl(d->fd, F_GET_SEALS);
+		if (seals == -1 || !(seals & F_SEAL_SHRINK) || 
+			fstat(d->fd, &st) != 0 || (size_t)st.st_size < bulk_data_offset + size) {
+			return false;
+		}
+		if (!d->map(bulk_data_offset + size)) {
+			return false;
+		}
+		if ((int)data.size() < size) {
+			data.resize(size);
+		}
+		memcpy(data.data(), d->region + bulk_data_offset, size);
+		d->header()->busy = 0; // the region can be used for the next message
+		return true;
+	}
+
+	bool Serializer::write_to(int fd, BulkBuffer *bulk, const WaitWritable &wait_writable) {
+		bool result = write_to_no_init(fd, bulk, wait_writable);
 		put_init();
 		return result;
 	}
-	bool Serializer::write_to_no_init(int fd) {
+	bool Serializer::write_to_no_init(int fd, BulkBuffer *bulk, const WaitWritable &wait_writable) {
 		int size = _data.size();
-		int result;
-		result = write_all(fd, (char*)&size, sizeof(size));
-		if (result < (int)sizeof(size)) {
-			//std::cerr << "write_all returned " << result << ". Expected result " << sizeof(size) << ". errno: " << strerror(errno) << std::endl;
+		if (wait_writable) {
+			wait_writable(fd);
+		}
+		if (bulk != nullptr && size > bulk_threshold && size <= bulk_max_size && bulk->put(_data)) {
+			// only the size is sent through the socket. It is negative to tell 
+			// the receiver that the data is in the BulkBuffer
+			int bulk_size = -size;
+			return ::write(fd, &bulk_size, sizeof(bulk_size)) == sizeof(bulk_size);
+		}
+		// the size and the beginning of the data are written as one record with one system call
+		int first_chunk = std::min(size, max_record_size - (int)sizeof(size));
+		struct iovec iov[2];
+		iov[0].iov_base = &size;
+		iov[0].iov_len  = sizeof(size);
+		iov[1].iov_base = _data.data();
+		iov[1].iov_len  = first_chunk;
+		int result = ::writev(fd, iov, 2);
+		if (result < (int)sizeof(size) + first_chunk) {
+			//std::cerr << "writev returned " << result << ". Expected result " << sizeof(size) + first_chunk << ". errno: " << strerror(errno) << std::endl;
 			return false;
 		}
 		// std::cerr << "write_to " << fd << " so many bytes " << size << std::endl;
-		result = write_all(fd, (char*)&_data[0], size);
-		if (result < size) {
-			//std::cerr << "write_all returned " << result << ". Expected result " << size << ". errno: " << strerror(errno) << std::endl;
-			return false;
+		if (size > first_chunk) { // large data is continued in chunks of max_record_size
+			result = write_all(fd, &_data[first_chunk], size - first_chunk, wait_writable);
+			if (result < size - first_chunk) {
+				//std::cerr << "write_all returned " << result << ". Expected result " << size - first_chunk << ". errno: " << strerror(errno) << std::endl;
+				return false;
+			}
 		}
 		// std::cerr << "wrote " << size << " bytes to fd " << fd << std::endl;
 		// put_init();
@@ -112,25 +253,59 @@ namespace saftbus {
 		_data.clear();
 	}
 
-	bool Deserializer::read_from(int fd) {
+	bool Deserializer::read_from(int fd, BulkBuffer *bulk) {
+		// The first record contains the size followed by the beginning of the data. It is received 
+		// with one system call. _data never shrinks, so usually the whole record fits into _data. 
+		// Otherwise the rest of the record is received in a per-thread overflow buffer and copied.
+		static thread_local std::vector<char> overflow(max_record_size);
+		if (_data.size() < _data.capacity()) {
+			_data.resize(_data.capacity());
+		}
 		int size;
-		int result;
-		result = read_all(fd, (char*)&size, sizeof(size));
+		struct iovec iov[3];
+		iov[0].iov_base = &size;
+		iov[0].iov_len  = sizeof(size);
+		iov[1].iov_base = _data.data();
+		iov[1].iov_len  = _data.size();
+		iov[2].iov_base = overflow.data();
+		iov[2].iov_len  = overflow.size();
+		int result = ::readv(fd, iov, 3);
 		// std::cerr << "read_from " << fd << " so many bytes: " << size << std::endl;
 		if (result < (int)sizeof(size)) {
-			//std::cerr << "read_all returned " << result << ". Expected result " << sizeof(size) << ". errno: " << strerror(errno) << std::endl;
+			//std::cerr << "readv returned " << result << ". Expected at least " << sizeof(size) << ". errno: " << strerror(errno) << std::endl;
 			return false;
 		}
-		_data.resize(size);
-		result = read_all(fd, (char*)&_data[0], size);
-		if (result < size) {
-			//std::cerr << "read_all returned " << result << ". Expected result " << size << ". errno: " << strerror(errno) << std::endl;
-			return false;
+		if (size < 0) { // the data was passed through the BulkBuffer
+			if (size == INT_MIN || bulk == nullptr || !bulk->get(_data, -size)) {
+				return false;
+			}
+			get_init();
+			return true;
+		}
+		int received = result - sizeof(size);
+		if ((int)_data.size() < size) {
+			int in_data = std::min(received, (int)_data.size());
+			_data.resize(size);
+			std::copy(overflow.begin(), overflow.begin() + (received - in_data), _data.begin() + in_data);
+		}
+		if (received < size) { // large data is continued in chunks of max_record_size
+			result = read_all(fd, &_data[received], size - received);
+			if (result < size - received) {
+				//std::cerr << "read_all returned " << result << ". Expected result " << size - received << ". errno: " << strerror(errno) << std::endl;
+				return false;
+			}
 		}
 		get_init();
 		// std::cerr << "read " << size << " bytes from fd " << fd << std::endl;
 		return true;
 	}
+	void Deserializer::swap(Deserializer &other)
+	{
+		// iterators stay valid and refer to the swapped content
+		_data.swap(other._data);
+		std::swap(_iter, other._iter);
+		std::swap(_saved_iter, other._saved_iter);
+	}
 	void Deserializer::save() const
 	{
 		_saved_iter = _iter;
@@ -180,7 +355,7 @@ namespace saftbus {
 	}
 
 
-	int recvfd(int socket) {
+	int recvfd(int socket, int timeout_ms) {
 		int len;
 		int fd;
 		char buf[1];
@@ -200,7 +375,16 @@ namespace saftbus {
 		msg.msg_control = (caddr_t) cms;
 		msg.msg_controllen = sizeof cms;
 
-		len = recvmsg(socket, &msg, 0);
+		if (timeout_ms >= 0) {
+			struct pollfd pfd;
+			pfd.fd = socket;
+			pfd.events = POLLIN;
+			if (poll(&pfd, 1, timeout_ms) <= 0 || !(pfd.revents & POLLIN)) {
+				return -1;
+			}
+		}
+
+		len = recvmsg(socket, &msg, timeout_ms >= 0 ? MSG_DONTWAIT : 0);
 
 		if (len < 0) {
 			return -1;
@@ -211,6 +395,9 @@ namespace saftbus {
 		}
 
 		cmsg = CMSG_FIRSTHDR(&msg);
+		if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+			return -1;
+		}
 		memmove(&fd, CMSG_DATA(cmsg), sizeof(int));
 		return fd;
 	}
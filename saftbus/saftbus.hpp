@@ -26,6 +26,8 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <functional>
 
 /// @brief classes and functions of the saftbus interprocess communication library.
 /// 
@@ -65,7 +67,37 @@ namespace saftbus {
 		EXCEPTION,
 	};
 
-	int write_all(int fd, const char *buffer, int size);
+	/// @brief function numbers of the hand-written Container_Service (object id 1, interface 0).
+	///
+	/// Container_Proxy sends them, Container_Service::call dispatches on them.
+	namespace container_function {
+		const int register_proxy         = 0;
+		const int unregister_proxy       = 1;
+		const int load_plugin            = 2;
+		const int unload_plugin          = 3;
+		const int remove_object          = 4;
+		const int quit                   = 5;
+		const int get_status             = 6;
+		const int execute_batch          = 7;
+		const int get_latency_histograms = 8;
+		const int set_latency_histograms = 9;
+		const int get_shared_fds         = 10;
+	}
+
+	/// @brief maximum size of one record (i.e. one message on a SOCK_SEQPACKET socket).
+	///
+	/// Serializer::write_to sends the size of the data and the beginning of the data together in
+	/// the first record. Only data that doesn't fit into the first record is continued in 
+	/// additional records of at most max_record_size bytes.
+	const int max_record_size = 100000;
+
+	/// @brief is called before each record is written and has to return when the fd is writable.
+	///
+	/// A ClientConnection with several requests in flight uses this to read replies while it writes, 
+	/// otherwise client and server could block each other on full sockets.
+	typedef std::function<void(int fd)> WaitWritable;
+
+	int write_all(int fd, const char *buffer, int size, const WaitWritable &wait_writable = WaitWritable());
 	int read_all(int fd, char *buffer, int size);
 
 	/// @brief Send given file descriptior via given socket
@@ -78,10 +110,43 @@ namespace saftbus {
 	/// @brief Receives file descriptor using given socket
 	///  
 	/// @param socket to be used for fd recepion
-	/// @return received file descriptor; -1 if failed
+	/// @param timeout_ms give up if no message arrives within this time (-1: wait forever)
+	/// @return received file descriptor; -1 if failed, timed out, or the message carried no file descriptor
 	///  
 	/// @note socket should be (PF_UNIX, SOCK_DGRAM)
-	int recvfd(int socket);
+	int recvfd(int socket, int timeout_ms = -1);
+
+	/// @brief messages larger than this are transferred through the BulkBuffer of a connection (if available)
+	const int bulk_threshold = max_record_size;
+	/// @brief messages larger than this are always sent through the socket
+	const int bulk_max_size = 256*1024*1024;
+
+	/// @brief shared memory region of one client connection, used to transfer large messages.
+	///
+	/// The ClientConnection creates the region (a memfd) and passes it to the ServerConnection with sendfd.
+	/// Serializer::write_to copies messages larger than bulk_threshold into the region and sends only 
+	/// the size through the socket. Deserializer::read_from copies them out of the region.
+	/// The region grows on demand up to bulk_max_size. It is sealed against shrinking, and the receiver 
+	/// refuses sizes that don't fit into the region; the connection is dropped in that case.
+	/// If the region is still occupied by a message that was not yet read, or if anything goes wrong
+	/// with the shared memory, the message is sent through the socket as usual.
+	class BulkBuffer {
+		struct Impl; std::unique_ptr<Impl> d;
+	public:
+		/// @brief take ownership of a file descriptor that was returned by create()
+		BulkBuffer(int fd);
+		~BulkBuffer();
+		/// @brief create a new shared memory file descriptor
+		/// @return the file descriptor, or -1 if shared memory is not available
+		static int create();
+		int get_fd() const;
+		/// @brief copy data into the region
+		/// @return false if the data has to be sent through the socket
+		bool put(const std::vector<char> &data);
+		/// @brief copy size bytes out of the region and release the region for the next message
+		/// @return false if the region cannot be read or doesn't contain size bytes
+		bool get(std::vector<char> &data, int size);
+	};
 
 	class Serializer;
 	class Deserializer;
@@ -95,6 +160,56 @@ namespace saftbus {
 	};
 
 
+	/// @brief read-only view of a contiguous array (similar to std::span<const T>)
+	///
+	/// A View has the same serialized representation as a std::vector<T>. 
+	/// If an exported function takes a "const saftbus::View<T> &" argument, the 
+	/// Proxy can be called with a std::vector<T> and the Service implementation reads 
+	/// the array directly from the receive buffer without copying it.
+	/// A View filled by a Deserializer is only valid until the next call to 
+	/// Deserializer::read_from, i.e. it must not be stored by the Service implementation.
+	template<typename T>
+	class View {
+	public:
+		View() : _begin(nullptr), _size(0) {}
+		View(const T *begin, size_t size) : _begin(begin), _size(size) {}
+		View(const std::vector<T> &std_vector) : _begin(std_vector.data()), _size(std_vector.size()) {}
+		const T* data()  const { return _begin; }
+		size_t   size()  const { return _size; }
+		bool     empty() const { return _size == 0; }
+		const T* begin() const { return _begin; }
+		const T* end()   const { return _begin + _size; }
+		const T& operator[](size_t i) const { return _begin[i]; }
+		std::vector<T> to_vector() const { return std::vector<T>(begin(), end()); }
+	private:
+		const T *_begin;
+		size_t   _size;
+	};
+
+	/// @brief read-only view of a string (similar to std::string_view)
+	///
+	/// A StringView has the same serialized representation as a std::string.
+	/// The same lifetime restrictions as for saftbus::View apply.
+	class StringView {
+	public:
+		StringView() : _begin(nullptr), _size(0) {}
+		StringView(const char *begin, size_t size) : _begin(begin), _size(size) {}
+		StringView(const std::string &std_string) : _begin(std_string.data()), _size(std_string.size()) {}
+		StringView(const char *c_string) : _begin(c_string), _size(std::char_traits<char>::length(c_string)) {}
+		const char* data()  const { return _begin; }
+		size_t      size()  const { return _size; }
+		bool        empty() const { return _size == 0; }
+		const char* begin() const { return _begin; }
+		const char* end()   const { return _begin + _size; }
+		const char& operator[](size_t i) const { return _begin[i]; }
+		std::string str() const { return std::string(_begin, _size); }
+		bool operator==(const StringView &rhs) const { return _size == rhs._size && std::char_traits<char>::compare(_begin, rhs._begin, _size) == 0; }
+		bool operator!=(const StringView &rhs) const { return !(*this == rhs); }
+	private:
+		const char *_begin;
+		size_t      _size;
+	};
+
 	/// @brief Simple serializer
 	///
 	/// Classes for serialization and de-serialization do not store type information, i.e. de-serialization 
@@ -120,8 +235,10 @@ namespace saftbus {
 		}
 
 		// write the length of the serdes data buffer and the buffer content to file descriptor fd
-		bool write_to(int fd);
-		bool write_to_no_init(int fd);
+		// large buffers are passed through bulk (if not nullptr)
+		// wait_writable (if set) is called before each record
+		bool write_to(int fd, BulkBuffer *bulk = nullptr, const WaitWritable &wait_writable = WaitWritable());
+		bool write_to_no_init(int fd, BulkBuffer *bulk = nullptr, const WaitWritable &wait_writable = WaitWritable());
 
 		// this looses in overload resolution against put<SerDesAble>(const T &val)
 		// so the wrong function is called... :(
@@ -170,6 +287,24 @@ namespace saftbus {
 				put(std_vector_vector[i]);
 			}
 		}
+		// saftbus::View (serialized like std::vector)
+		template<typename T>
+		void put(const View<T>& view) {
+			size_t size = view.size();
+			put(size);
+			const char* begin = reinterpret_cast<const char*>(view.data());
+			const char* end   = begin + size*sizeof(T);
+			while(_data.size()%sizeof(T) != 0) _data.push_back('x'); // insert padding (reading from address that is not aligned to target type is undefined behavior)
+			_data.insert(_data.end(), begin, end);
+		}
+		template<typename T>
+		void put(const std::vector< View<T> >& std_vector_view) {
+			size_t size = std_vector_view.size();
+			put(size);
+			for (size_t i = 0; i < size; ++i) {
+				put(std_vector_view[i]);
+			}
+		}
 		// std::string 
 		void put(const std::string& std_string) {
 			size_t size = std_string.size();
@@ -178,6 +313,12 @@ namespace saftbus {
 			const char* end   = begin + size*sizeof(std_string[0]);
 			_data.insert(_data.end(), begin, end);
 		}
+		// saftbus::StringView (serialized like std::string)
+		void put(const StringView& string_view) {
+			size_t size = string_view.size();
+			put(size);
+			_data.insert(_data.end(), string_view.begin(), string_view.end());
+		}
 		// std::vector<std::string>
 		void put(const std::vector<std::string>& vector_string) {
 			size_t size = vector_string.size();
@@ -196,16 +337,19 @@ namespace saftbus {
 				put(it->second);
 			}
 		}
-		// // nested Serializer
-		// void put(Serializer &ser) {
-		// 	put(ser._data);
-		// 	ser.put_init();
-		// }
+		// nested Serializer (the content of ser is moved, ser is empty afterwards)
+		void put(Serializer &ser) {
+			put(ser._data);
+			ser.put_init();
+		}
 
 		bool empty();
 
 		// has to be called before first call to put()
 		void put_init();
+
+		// the serialized data (without the size that is prepended by write_to)
+		const std::vector<char>& data() const { return _data; }
 	private:
 
 
@@ -226,7 +370,8 @@ namespace saftbus {
 		}
 
 		// fill the serdes data buffer by reading data from the file descriptor fd
-		bool read_from(int fd);
+		// large buffers are taken from bulk (must be the BulkBuffer that was passed to write_to on the other side)
+		bool read_from(int fd, BulkBuffer *bulk = nullptr);
 
 		// Types derived from SerDesAble
 		template<typename T>
@@ -275,6 +420,31 @@ namespace saftbus {
 			std_string.insert(std_string.end(), begin, end);
 			_iter += size;
 		}
+		// saftbus::View points into the receive buffer and is valid until the next call to read_from
+		template<typename T>
+		void get(View<T> &view) const {
+			size_t size;
+			get(size);
+			while((_iter-_data.begin())%sizeof(T) != 0) _iter+=sizeof('x'); // skip padding
+			view   = View<T>(reinterpret_cast<const T*>(_data.data() + (_iter-_data.begin())), size);
+			_iter += sizeof(T)*size;
+		}
+		template<typename T>
+		void get(std::vector< View<T> > &std_vector_view) const {
+			size_t size;
+			get(size);
+			std_vector_view.resize(size);
+			for (size_t i = 0; i < size; ++i) {
+				get(std_vector_view[i]);
+			}
+		}
+		// saftbus::StringView points into the receive buffer and is valid until the next call to read_from
+		void get(StringView &string_view) const {
+			size_t size;
+			get(size);
+			string_view = StringView(_data.data() + (_iter-_data.begin()), size);
+			_iter += size;
+		}
 		// std::vector<std::string>
 		void get(std::vector<std::string> &vector_string) const {
 			size_t size;
@@ -298,15 +468,18 @@ namespace saftbus {
 				std_map.insert(std::make_pair(key,value));
 			}
 		}
-		// // nested Deserializer
-		// void get(Deserializer &ser) const {
-		// 	get(ser._data);
-		// 	ser.get_init();
-		// }
+		// nested Deserializer
+		void get(Deserializer &ser) const {
+			get(ser._data);
+			ser.get_init();
+		}
 
 		void save() const;
 		void restore() const;
 
+		// exchange the content (including the read position) with another Deserializer
+		void swap(Deserializer &other);
+
 	private:
 
 		// has to be called before first call to get()
@@ -46,6 +46,16 @@ void usage(char *argv0) {
 		std::cout << std::endl;
 		std::cout << " -h | --help         print this help and exit." << std::endl;
 		std::cout << std::endl;
+		std::cout << " --signal-buffer <n> buffer up to <n> signals per signal file descriptor" << std::endl;
+		std::cout << "                     if a client cannot receive them immediately." << std::endl;
+		std::cout << "                     default is 1024." << std::endl;
+		std::cout << std::endl;
+		std::cout << " --signal-overflow <policy>" << std::endl;
+		std::cout << "                     what to do when a signal buffer is full:" << std::endl;
+		std::cout << "                       drop-oldest  discard the oldest buffered signal (default)" << std::endl;
+		std::cout << "                       drop-newest  discard the new signal" << std::endl;
+		std::cout << "                       disconnect   disconnect the client" << std::endl;
+		std::cout << std::endl;
 }
 
 
@@ -96,12 +106,34 @@ int main(int argc, char *argv[]) {
 	try {
 
 		std::vector<std::pair<std::string, std::vector<std::string> > > plugins_and_args;
+		unsigned max_pending_signals = 1024;
+		saftbus::ServerConnection::SignalOverflowPolicy overflow_policy = saftbus::ServerConnection::DROP_OLDEST;
 		for (int i = 1; i < argc; ++i) {
 			std::string argvi(argv[i]);
 			if (argvi == "-h" || argvi == "--help") {
 				usage(argv[0]);
 				return 0;
 			}
+			if (plugins_and_args.empty() && argvi == "--signal-buffer") {
+				if (++i >= argc || !is_int(argv[i])) {
+					std::cerr << "Error: expect number after --signal-buffer" << std::endl;
+					return 1;
+				}
+				std::istringstream in(argv[i]);
+				in >> max_pending_signals;
+				continue;
+			}
+			if (plugins_and_args.empty() && argvi == "--signal-overflow") {
+				std::string policy = (++i < argc) ? argv[i] : "";
+				if      (policy == "drop-oldest") overflow_policy = saftbus::ServerConnection::DROP_OLDEST;
+				else if (policy == "drop-newest") overflow_policy = saftbus::ServerConnection::DROP_NEWEST;
+				else if (policy == "disconnect")  overflow_policy = saftbus::ServerConnection::DISCONNECT;
+				else {
+					std::cerr << "Error: expect drop-oldest, drop-newest, or disconnect after --signal-overflow" << std::endl;
+					return 1;
+				}
+				continue;
+			}
 			if (detect_so_file(argvi)) {
 				std::cerr << argvi << " is plugin" << std::endl;
 				plugins_and_args.push_back(std::make_pair(argvi, std::vector<std::string>()));
@@ -122,6 +154,7 @@ int main(int argc, char *argv[]) {
 		}
 
 		saftbus::ServerConnection server_connection(plugins_and_args);
+		server_connection.set_signal_buffer(max_pending_signals, overflow_policy);
 
 		// add allocator fillstate as additional info to be reported by Container::get_status()
 		if (print_fillstate().size()) server_connection.get_container()->add_additional_info_callback("allocator", &print_fillstate);
@@ -30,6 +30,9 @@
 #include <cassert>
 #include <set>
 #include <map>
+#include <deque>
+#include <cerrno>
+#include <cstring>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -40,19 +43,135 @@
 
 namespace saftbus {
 
+	// this is equal to the client id as long as a client request is handled in this thread
+	static thread_local int calling_client_id = -1;
+
+	ServerConnection::CallingClient::CallingClient(int client_id) 
+		: previous_client_id(calling_client_id)
+	{
+		calling_client_id = client_id;
+	}
+	ServerConnection::CallingClient::~CallingClient() 
+	{
+		calling_client_id = previous_client_id;
+	}
+
+
+	// A signal that could not be written completely to its signal fd.
+	// Signals are framed like in Serializer::write_to: the first record contains the size
+	// and the beginning of the payload, the rest follows in records of at most max_record_size bytes.
+	// On a SOCK_SEQPACKET socket each record is written completely or not at all,
+	// which allows to resume a partially written signal at the next record boundary.
+	struct PendingSignal {
+		unsigned object_id;                             // the Service that emitted the signal
+		std::shared_ptr<const std::vector<char> > data; // the payload, shared by all signal fds that buffer the same signal
+		int size;                                       // the content of the size record
+		int written;                                    // number of bytes written so far, including the size record
+	};
+
+	// Signals that wait for a signal fd to become writable
+	struct SignalQueue {
+		std::deque<PendingSignal> signals;
+		SourceHandle flush_source; // IoSource waiting for POLLOUT as long as signals are pending
+	};
+
+	static const int max_records_per_call = 64;  // maximum number of records passed to one sendmmsg call
+
+	// one record consists of one or two parts: the first record of a signal has the size and the
+	// beginning of the payload, all others only payload
+	struct Record {
+		struct iovec iov[2];
+		size_t iovlen;
+	};
+
+	// Size of the record that starts after the given number of written bytes
+	static int record_size(int size, int written) {
+		const int header_size = sizeof(size);
+		if (written == 0) {
+			return header_size + std::min(size, max_record_size - header_size);
+		}
+		return std::min(header_size + size - written, max_record_size);
+	}
+
+	// Append the records of a signal that are not yet written to the list of records.
+	// No more than max_records_per_call records are collected.
+	static void gather_records(std::vector<Record> &records, const int &size, const char *payload, int written) {
+		const int header_size = sizeof(size);
+		while (written < header_size + size && records.size() < max_records_per_call) {
+			Record record;
+			int n = record_size(size, written);
+			if (written == 0) {
+				record.iov[0].iov_base = (void*)&size;
+				record.iov[0].iov_len  = header_size;
+				record.iov[1].iov_base = (void*)payload;
+				record.iov[1].iov_len  = n - header_size;
+				record.iovlen = 2;
+			} else {
+				record.iov[0].iov_base = (void*)(payload + written - header_size);
+				record.iov[0].iov_len  = n;
+				record.iovlen = 1;
+			}
+			records.push_back(record);
+			written += n;
+		}
+	}
+
+	// Advance the written bytes of a signal by up to n records. 
+	// Returns the number of records that were skipped.
+	static int skip_records(int size, int &written, int n) {
+		const int header_size = sizeof(size);
+		int skipped = 0;
+		for (; skipped < n && written < header_size + size; ++skipped) {
+			written += record_size(size, written);
+		}
+		return skipped;
+	}
+
+	static bool completely_written(int size, int written) {
+		return written == (int)sizeof(size) + size;
+	}
+
+	// Write all records with one system call, each record is one message on the SOCK_SEQPACKET socket.
+	// Returns the number of records written, 0 if fd would block, -1 on error.
+	static int send_records(int fd, std::vector<Record> &records) {
+		struct mmsghdr msgs[max_records_per_call];
+		int n = std::min((int)records.size(), max_records_per_call);
+		memset(msgs, 0, n*sizeof(struct mmsghdr));
+		for (int i = 0; i < n; ++i) {
+			msgs[i].msg_hdr.msg_iov    = records[i].iov;
+			msgs[i].msg_hdr.msg_iovlen = records[i].iovlen;
+		}
+		for (;;) {
+			int result = sendmmsg(fd, msgs, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+			if (result >= 0) {
+				return result;
+			}
+			if (errno == EINTR) continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+			return -1;
+		}
+	}
 
 	// Client represents the program (running in another process)
 	// that sent us one file descriptor of a socket pair.
 	// The file descriptor integer value serves as a unique id to identify this other process.
 	struct Client {
 		int socket_fd; // the file descriptor is a unique number and is used as a client id
+		unsigned long serial; // distinguishes clients that got the same socket_fd one after another
 		pid_t process_id; // store the clients pid as additional useful information
 		SourceHandle io_source; // use this to disconnect the source in the destructor
 		std::map<int,int> signal_fd_use_count;
-		Client(int fd, pid_t pid, SourceHandle h) : socket_fd(fd), process_id(pid), io_source(h)
+		std::map<int,SignalQueue> signal_queues; // one bounded queue per signal fd
+		int dropped_signals;     // number of signals dropped on any signal fd of this client
+		bool disconnect_pending; // set when the signal buffer overflowed with SignalOverflowPolicy DISCONNECT
+		std::unique_ptr<BulkBuffer> bulk; // shared memory for large messages (nullptr if the client has none)
+		Client(int fd, unsigned long s, pid_t pid, SourceHandle h, std::unique_ptr<BulkBuffer> b) : socket_fd(fd), serial(s), process_id(pid), io_source(h), dropped_signals(0), disconnect_pending(false), bulk(std::move(b))
 		{}
 		~Client() {
 			Loop::get_default().remove(io_source);
+			for (auto &fd_queue: signal_queues) {
+				Loop::get_default().remove(fd_queue.second.flush_source);
+			}
 			if (signal_fd_use_count.size() > 0) {
 				//===std::cerr << "not all signal fds of client " << (int)socket_fd << " were closed" << std::endl;
 			}
@@ -88,13 +207,21 @@ namespace saftbus {
 		std::vector<std::unique_ptr<Client> > clients;
 		Serializer   send;
 		Deserializer received;
-		int calling_client_id; // this is equal to the client id as long as a client request is handled
-		Impl(ServerConnection *connection) : container_of_services(connection), calling_client_id(-1) {}
+		unsigned long client_serial; // incremented for each accepted client
+		std::map<int, Client*> signal_fd_clients; // find the Client that owns a signal fd
+		unsigned max_pending_signals;
+		SignalOverflowPolicy overflow_policy;
+		Impl(ServerConnection *connection) : container_of_services(connection), client_serial(0), max_pending_signals(1024), overflow_policy(DROP_OLDEST) {}
 		~Impl() {
 		}
 		bool accept_client(int fd, int condition);
-		bool handle_client_request(int fd, int condition);
+		bool handle_client_request(int fd, int condition, BulkBuffer *bulk, unsigned long serial);
+		void send_reply(int client_fd, unsigned long serial, size_t reply_start, Serializer &reply);
 		void client_hung_up(int client_fd);
+		std::vector<Record> records; // reused for each signal transfer
+		bool flush_signals(int signal_fd, int condition);
+		void signal_dropped(Client *client, int signal_fd, unsigned object_id);
+		void disconnect_client(Client *client);
 	};
 
 	std::vector<ServerConnection::ClientInfo> ServerConnection::get_client_info() {
@@ -104,6 +231,11 @@ namespace saftbus {
 			result.back().process_id = client->process_id;
 			result.back().client_fd  = client->socket_fd;
 			result.back().signal_fds = client->signal_fd_use_count;
+			result.back().pending_signals = 0;
+			for (auto &fd_queue: client->signal_queues) {
+				result.back().pending_signals += fd_queue.second.signals.size();
+			}
+			result.back().dropped_signals = client->dropped_signals;
 		}
 		return result;
 	}
@@ -121,9 +253,24 @@ namespace saftbus {
 			if (result != sizeof(pid)) {
 				std::cerr << "Error in ServerConnection::Impl::accept_client: read unexpected number of bytes" << std::endl;
 			}
-			auto handle = Loop::get_default().connect<IoSource>(std::bind(&ServerConnection::Impl::handle_client_request, this, std::placeholders::_1, std::placeholders::_2), client_socket_fd, POLLIN | POLLHUP | POLLERR);
+			// receive the shared memory for large messages
+			std::unique_ptr<BulkBuffer> bulk;
+			int has_bulk = 0;
+			result = read(client_socket_fd, &has_bulk, sizeof(has_bulk));
+			if (result != sizeof(has_bulk)) {
+				std::cerr << "Error in ServerConnection::Impl::accept_client: read unexpected number of bytes" << std::endl;
+			} else if (has_bulk) {
+				int bulk_fd = recvfd(client_socket_fd);
+				if (bulk_fd == -1) {
+					std::cerr << "Error in ServerConnection::Impl::accept_client: cannot receive bulk buffer fd" << std::endl;
+				} else {
+					bulk.reset(new BulkBuffer(bulk_fd));
+				}
+			}
+			unsigned long serial = ++client_serial;
+			auto handle = Loop::get_default().connect<IoSource>(std::bind(&ServerConnection::Impl::handle_client_request, this, std::placeholders::_1, std::placeholders::_2, bulk.get(), serial), client_socket_fd, POLLIN | POLLHUP | POLLERR);
 			// register the client
-			clients.push_back(std::move(std::unique_ptr<Client>(new Client(client_socket_fd, pid, handle))));
+			clients.push_back(std::move(std::unique_ptr<Client>(new Client(client_socket_fd, serial, pid, handle, std::move(bulk)))));
 			// send the ID back to client (the file descriptor integer number is used as ID)
 			result = write(client_socket_fd, &client_socket_fd, sizeof(client_socket_fd));
 			if (result != sizeof(client_socket_fd)) {
@@ -133,26 +280,36 @@ namespace saftbus {
 		return true;
 	}
 
-	bool ServerConnection::Impl::handle_client_request(int fd, int condition) {
-		// The calling_client_id should be reset to -1 at end of scope.
-		// This anonymous struct guarantees that this is the case
-		struct ClientID {
-			int &ref;
-			ClientID(int &id_ref, int id_value) : ref(id_ref) { id_ref = id_value; }
-			~ClientID() { ref = -1; }
-		} ccid(calling_client_id, fd); 
+	bool ServerConnection::Impl::handle_client_request(int fd, int condition, BulkBuffer *bulk, unsigned long serial) {
+		// The calling_client_id is reset at end of scope.
+		ServerConnection::CallingClient ccid(fd);
 
 		if (condition & (POLLIN|POLLHUP) ) {
 			// if POLLHUP is received, there may still be data inside the pipe
 			// we have to loop and read until all data is read and all remaining actions 
 			// are executed. But not more then 100 times. 
-			bool read_result = received.read_from(fd);
+			bool read_result = received.read_from(fd, bulk);
 			if (!read_result) {
 				client_hung_up(fd);
 				return false;
 			}
+			// the reply starts with the request id so that the client can match it to the request
+			uint32_t request_id;
+			received.get(request_id);
 			unsigned saftbus_object_id;
 			received.get(saftbus_object_id);
+			if (container_of_services.runs_in_loop_thread(saftbus_object_id)) {
+				// Services that were created in a LoopThread are called there, the reply is sent when 
+				// the call is done. Meanwhile this Loop can handle other requests.
+				std::shared_ptr<Serializer> reply(new Serializer);
+				reply->put(request_id);
+				size_t reply_start = reply->data().size();
+				container_of_services.call_service_in_loop(saftbus_object_id, fd, received, reply, 
+					[this, fd, serial, reply_start, reply]() { send_reply(fd, serial, reply_start, *reply); });
+				return true;
+			}
+			send.put(request_id);
+			size_t reply_start = send.data().size();
 			if (!container_of_services.call_service(saftbus_object_id, fd, received, send)) { 
 				// call_service returns false if the service object was not found
 				// in this case an exception is sent to the Proxy 
@@ -160,8 +317,10 @@ namespace saftbus {
 				std::string what("remote call failed because service object was not found");
 				send.put(what);
 			} 
-			if (!send.empty()) {
-				send.write_to(fd);
+			if (send.data().size() > reply_start) {
+				send.write_to(fd, bulk);
+			} else { // some requests (e.g. unregister_proxy) have no reply
+				send.put_init();
 			}
 		}
 		return true;
@@ -171,11 +330,21 @@ namespace saftbus {
 	bool operator==(const std::unique_ptr<Client> &lhs, int rhs) {
 		return lhs->socket_fd == rhs;
 	}
+
+	// send a reply that was prepared in a LoopThread, unless the client hung up in the meantime
+	void ServerConnection::Impl::send_reply(int client_fd, unsigned long serial, size_t reply_start, Serializer &reply) {
+		auto client = std::find(clients.begin(), clients.end(), client_fd);
+		if (client == clients.end() || (*client)->serial != serial) {
+			return;
+		}
+		if (reply.data().size() > reply_start) {
+			reply.write_to(client_fd, (*client)->bulk.get());
+		}
+	}
 	void ServerConnection::Impl::client_hung_up(int client_fd) 
 	{
 		auto removed_client = std::find(clients.begin(), clients.end(), client_fd);
 		if (removed_client == clients.end()) { 
-			calling_client_id = -1;
 			assert(false);
 		} else {
 			// remove all signal fds associated with this client from all services
@@ -183,6 +352,7 @@ namespace saftbus {
 				int sigfd = sigfd_usecount.first;
 				// int count = sigfd_usecount.second;
 				container_of_services.remove_signal_fd(sigfd);
+				signal_fd_clients.erase(sigfd);
 			}
 			clients.erase(std::remove(clients.begin(), clients.end(), client_fd), clients.end());
 		}
@@ -191,6 +361,76 @@ namespace saftbus {
 		container_of_services.client_hung_up(client_fd);
 	}
 
+	bool ServerConnection::Impl::flush_signals(int signal_fd, int condition)
+	{
+		auto owner = signal_fd_clients.find(signal_fd);
+		if (owner == signal_fd_clients.end()) {
+			return false;
+		}
+		auto &queue = owner->second->signal_queues[signal_fd];
+		if (condition & POLLOUT) {
+			while (!queue.signals.empty()) {
+				// write records of as many pending signals as possible with one system call
+				records.clear();
+				for (auto &signal: queue.signals) {
+					gather_records(records, signal.size, signal.data->data(), signal.written);
+					if (records.size() >= max_records_per_call) {
+						break;
+					}
+				}
+				int result = send_records(signal_fd, records);
+				if (result == 0) {
+					return true; // wait for the next POLLOUT
+				}
+				if (result < 0) {
+					break;
+				}
+				while (result > 0 && !queue.signals.empty()) {
+					auto &signal = queue.signals.front();
+					result -= skip_records(signal.size, signal.written, result);
+					if (!completely_written(signal.size, signal.written)) {
+						break;
+					}
+					queue.signals.pop_front();
+				}
+			}
+		}
+		// Either all signals are written, or the client is gone. In the latter case 
+		// the pending signals are discarded. The hung-up is detected on the client socket. 
+		queue.signals.clear();
+		queue.flush_source = SourceHandle();
+		return false;
+	}
+
+	void ServerConnection::Impl::signal_dropped(Client *client, int signal_fd, unsigned object_id)
+	{
+		++client->dropped_signals;
+		container_of_services.signal_dropped(object_id, signal_fd);
+	}
+
+	void ServerConnection::Impl::disconnect_client(Client *client)
+	{
+		if (client->disconnect_pending) {
+			return;
+		}
+		std::cerr << "signal buffer overflow: disconnect client " << client->socket_fd << " (pid=" << client->process_id << ")" << std::endl;
+		client->disconnect_pending = true;
+		for (auto &fd_queue: client->signal_queues) {
+			Loop::get_default().remove(fd_queue.second.flush_source);
+			fd_queue.second.flush_source = SourceHandle();
+			fd_queue.second.signals.clear();
+		}
+		// The client cannot be removed here because this function is called while a Service is emitting a signal.
+		int client_fd = client->socket_fd;
+		Loop::get_default().connect<TimeoutSource>([this, client_fd]() {
+				auto client = std::find(clients.begin(), clients.end(), client_fd);
+				if (client != clients.end() && (*client)->disconnect_pending) {
+					client_hung_up(client_fd);
+				}
+				return false;
+			}, std::chrono::milliseconds(0));
+	}
+
 
 	ServerConnection::ServerConnection(const std::vector<std::pair<std::string, std::vector<std::string> > > &plugins_and_args, const std::string &socket_name) 
 		: d(new Impl(this))
@@ -265,6 +505,7 @@ namespace saftbus {
 			assert(false);
 		} else {
 			(*client)->use_signal_fd(signal_fd);
+			d->signal_fd_clients[signal_fd] = client->get();
 		}
 	}
 
@@ -280,7 +521,83 @@ namespace saftbus {
 	}
 
 	int ServerConnection::get_calling_client_id() {
-		return d->calling_client_id;
+		return calling_client_id;
+	}
+
+	void ServerConnection::set_signal_buffer(unsigned max_pending_signals, SignalOverflowPolicy policy)
+	{
+		d->max_pending_signals = std::max(max_pending_signals, 1u);
+		d->overflow_policy     = policy;
+	}
+
+	void ServerConnection::send_signal(const std::vector<int> &signal_fds, unsigned object_id, const Serializer &send)
+	{
+		const std::vector<char> &data = send.data();
+		const int size = data.size();
+		std::shared_ptr<const std::vector<char> > shared_data; // only created if the signal has to be buffered
+		for (int signal_fd: signal_fds) {
+			auto owner = d->signal_fd_clients.find(signal_fd);
+			if (owner == d->signal_fd_clients.end()) {
+				continue;
+			}
+			Client *client = owner->second;
+			if (client->disconnect_pending) {
+				d->signal_dropped(client, signal_fd, object_id);
+				continue;
+			}
+			auto &queue = client->signal_queues[signal_fd];
+			int written = 0;
+			if (queue.signals.empty()) {
+				// all records of the signal are written with one system call
+				d->records.clear();
+				gather_records(d->records, size, data.data(), written);
+				int result = send_records(signal_fd, d->records);
+				if (result < 0) { // the client is gone, this will be detected on the client socket
+					continue;
+				}
+				skip_records(size, written, result);
+				if (completely_written(size, written)) {
+					continue;
+				}
+			}
+			// A partially written signal must be completed before anything else can be sent.
+			// It cannot be dropped and is always put into the queue.
+			if (written == 0 && queue.signals.size() >= d->max_pending_signals) {
+				bool dropped = true;
+				switch(d->overflow_policy) {
+					case DROP_OLDEST: {
+						auto oldest = queue.signals.begin();
+						if (oldest->written > 0) {
+							++oldest;
+						}
+						if (oldest == queue.signals.end()) { // nothing that can be dropped
+							d->signal_dropped(client, signal_fd, object_id);
+						} else {
+							d->signal_dropped(client, signal_fd, oldest->object_id);
+							queue.signals.erase(oldest);
+							dropped = false;
+						}
+					} break;
+					case DROP_NEWEST:
+						d->signal_dropped(client, signal_fd, object_id);
+					break;
+					case DISCONNECT:
+						d->signal_dropped(client, signal_fd, object_id);
+						d->disconnect_client(client);
+					break;
+				}
+				if (dropped) {
+					continue;
+				}
+			}
+			if (!shared_data) {
+				shared_data = std::make_shared<const std::vector<char> >(data);
+			}
+			queue.signals.push_back(PendingSignal{object_id, shared_data, size, written});
+			if (!queue.flush_source.connected()) {
+				queue.flush_source = Loop::get_default().connect<IoSource>(std::bind(&ServerConnection::Impl::flush_signals, d.get(), std::placeholders::_1, std::placeholders::_2), signal_fd, POLLOUT);
+			}
+		}
 	}
 	void set_owner();
 	void release_owner();
@@ -31,6 +31,7 @@
 namespace saftbus {
 
 	class Container;
+	class Serializer;
 
 	/// @brief provide a single named UNIX domain socket in the file system and handle client request on that socket
 	/// 
@@ -62,8 +63,44 @@ namespace saftbus {
 		void unregister_signal_id_for_client(int client_id, int signal_id);
 
 		/// @brief return the client id of the currently active client
+		///
+		/// The client id is maintained per thread, because requests for Services 
+		/// that were created in a LoopThread are executed in that thread.
 		int get_calling_client_id();
 
+		/// @brief As long as an object of this type exists, get_calling_client_id 
+		/// returns client_id in the thread that created the object.
+		class CallingClient {
+			int previous_client_id;
+		public:
+			CallingClient(int client_id);
+			~CallingClient();
+		};
+
+		/// @brief what happens if a signal is emitted to a client whose signal buffer is full
+		enum SignalOverflowPolicy {
+			DROP_OLDEST, ///< discard the oldest buffered signal that was not yet (partially) sent
+			DROP_NEWEST, ///< discard the signal that is being emitted
+			DISCONNECT,  ///< treat the client as hung up
+		};
+		/// @brief configure the outbound signal buffer of each signal file descriptor.
+		///
+		/// Signals that cannot be written immediately to a signal file descriptor are buffered 
+		/// and written as soon as the file descriptor becomes writable again. 
+		/// @param max_pending_signals maximum number of buffered signals per signal file descriptor
+		/// @param policy what to do if a signal arrives at a full buffer
+		void set_signal_buffer(unsigned max_pending_signals, SignalOverflowPolicy policy);
+
+		/// @brief send a signal to a number of signal file descriptors without blocking.
+		///
+		/// The signal is framed once and written with one system call per signal file descriptor 
+		/// if possible. Otherwise it is buffered. Dropped signals are counted for the client and 
+		/// for the Service.
+		/// @param signal_fds the signal file descriptors of all receiving clients
+		/// @param object_id the saftbus object id of the emitting Service (used to count dropped signals)
+		/// @param send contains the serialized signal
+		void send_signal(const std::vector<int> &signal_fds, unsigned object_id, const Serializer &send);
+
 		/// @brief access the saftbus::Container that stores all services.
 		/// The container is owned by the ServerConnection object.
 		Container* get_container();
@@ -72,6 +109,8 @@ namespace saftbus {
 			pid_t process_id;
 			int client_fd;
 			std::map<int,int> signal_fds;
+			int pending_signals; // number of buffered signals that wait for the client to become writable
+			int dropped_signals; // number of signals that were dropped because the signal buffer was full
 		};
 		std::vector<ClientInfo> get_client_info();
 	};
@@ -29,19 +29,36 @@
 #include <set>
 #include <cassert>
 #include <sstream>
+#include <atomic>
 
 #include <unistd.h>
+#include <sys/socket.h>
 
 namespace saftbus {
 
+	// Execute driver code of a Service in the thread where the driver lives.
+	// loop is nullptr if the driver lives in the thread of the Container.
+	static void run_in_service_thread(Loop *loop, const std::function<void()> &work) {
+		if (loop) {
+			loop->invoke_and_wait(work);
+		} else {
+			work();
+		}
+	}
+
 	struct Service::Impl {
-		int owner;
+		std::atomic<int> owner; // may be changed by a driver that lives in a LoopThread
 		std::map<int, std::pair<int, int> > signal_fds_use_count_and_dropped_signals;
 		std::vector<std::string> interface_names;
 		std::string object_path;
 		uint64_t object_id;
 		std::function<void()> destruction_callback; // a funtion can be attatched here that is called whenever the service is destroyed
 		bool destroy_if_owner_quits; 
+		ServerConnection *connection; // signals are sent through the connection of the Container that owns the Service
+		Container *container;         // the Container that owns the Service
+		Loop *loop;                   // the LoopThread that created the Service, nullptr if it was created in the thread of the Container
+		std::shared_ptr<Service> self; // doesn't own the Service, calls that wait in the Loop of the Service use a weak_ptr to see if it still exists
+		std::vector<int> emit_fds;    // reused in each call to emit
 		void remove_signal_fd(int fd);
 	};
 
@@ -53,6 +70,19 @@ namespace saftbus {
 		std::map<std::string, unsigned> object_path_lookup_table; // maps object_path to saftbus_object_id
 		std::vector<Service*> removed_services;
 		std::map<std::string, std::function<std::string(void)> > additional_info_callbacks; // allow plugins to add additional info to be shown by "saftbus-ctl -s"
+		std::map<std::pair<std::string, std::string>, std::vector<int> > shared_fds; // (object_path, name) -> file descriptors that clients can get
+		Loop *loop; // the Loop of the thread that uses the Container
+		bool in_other_thread() {
+			return &Loop::get_default() != loop;
+		}
+		// execute a Container function that was called from a LoopThread in the thread of the Container
+		void run_in_container_thread(const std::function<void()> &work) {
+			int client_id = connection->get_calling_client_id();
+			loop->invoke_and_wait([&]() {
+				ServerConnection::CallingClient calling_client(client_id);
+				work();
+			});
+		}
 		void reset_children_first(const std::string &object_path) {
 			if (object_path == "/saftbus") return;
 			bool found_child = false;
@@ -67,7 +97,8 @@ namespace saftbus {
 			}
 			if (!found_child) {
 				auto id = object_path_lookup_table[object_path];
-				objects[id].reset();
+				auto &service = objects[id];
+				run_in_service_thread(service->d->loop, [&]() { service.reset(); });
 				object_path_lookup_table.erase(object_path);
 			}
 
@@ -81,7 +112,7 @@ namespace saftbus {
 				auto last = objects.end();
 				--last;
 				if (last->second->d->destruction_callback) {
-					last->second->d->destruction_callback();
+					run_in_service_thread(last->second->d->loop, last->second->d->destruction_callback);
 				}
 				reset_children_first(last->second->d->object_path);
 				// erase all reset-ed entries
@@ -117,9 +148,13 @@ namespace saftbus {
 		: d(new Impl)
 	{
 		d->owner = -1;
+		d->connection = nullptr;
+		d->container = nullptr;
+		d->loop = nullptr;
 		d->interface_names = interface_names;
 		d->destruction_callback = destruction_callback;
 		d->destroy_if_owner_quits = destroy_if_owner_quits;
+		d->self = std::shared_ptr<Service>(this, [](Service*) {});
 	}
 	Service::~Service() {
 	}
@@ -182,22 +217,36 @@ namespace saftbus {
 
 	void Service::emit(Serializer &send)
 	{
+		if (d->container && d->container->d->in_other_thread()) {
+			// the signal fds are managed in the thread of the Container
+			std::shared_ptr<Serializer> signal(new Serializer(send));
+			Container *container = d->container;
+			unsigned object_id = d->object_id;
+			container->d->loop->invoke([container, object_id, signal]() {
+				auto find_result = container->d->objects.find(object_id);
+				if (find_result != container->d->objects.end() && find_result->second) {
+					find_result->second->emit(*signal);
+				}
+			});
+			send.put_init();
+			return;
+		}
+		LatencyTimer timer(signal_emit_latency);
+		d->emit_fds.clear();
 		for (auto &fd_use_count_dropped: d->signal_fds_use_count_and_dropped_signals) {
 			auto &fd              = fd_use_count_dropped.first;
 			auto &use_count       = fd_use_count_dropped.second.first;
-			auto &dropped_signals = fd_use_count_dropped.second.second;
 			if (use_count > 0) { // only send data if use count is > 0
-				struct pollfd pfd;
-				pfd.fd = fd;
-				pfd.events = POLLOUT;
-				if (poll(&pfd, 1, 0) <= 0) { // fd is not ready immediately => drop the signal
-					++dropped_signals;      // count number of dropped signals (this number can be seen when with "saftbus-ctl -s")
-				} else {
-					send.write_to_no_init(fd); // The same data is written multiple times. Therefore the
-				}                             // put_init function must not be called automatically after write
-			}                                //
-		}                                   // but manually after the for loop 
-		send.put_init();                   // <- here
+				d->emit_fds.push_back(fd);
+			}
+		}
+		// The data is framed once and written to all fds. Signals that cannot be written immediately 
+		// are buffered by the connection. If a signal has to be dropped, the connection counts it 
+		// (this number can be seen with "saftbus-ctl -s").
+		if (!d->emit_fds.empty()) {
+			d->connection->send_signal(d->emit_fds, d->object_id, send);
+		}
+		send.put_init();
 	}
 
 	int Service::get_object_id() 
@@ -229,12 +278,29 @@ namespace saftbus {
 	Container_Service::~Container_Service() 
 	{
 	}
+	// how long the Container waits for a file descriptor that a client sends after its request
+	static const int back_channel_timeout_ms = 100;
+
+	// Container::register_proxy (function 0) and Container::get_shared_fds (function 10) receive 
+	// a file descriptor after the request
+	static bool passes_fd(unsigned saftbus_object_id, saftbus::Deserializer &call) {
+		if (saftbus_object_id != 1) { // Container_Service
+			return false;
+		}
+		int interface_no, function_no;
+		call.save();
+		call.get(interface_no);
+		call.get(function_no);
+		call.restore();
+		return interface_no == 0 && (function_no == container_function::register_proxy || function_no == container_function::get_shared_fds);
+	}
+
 	void Container_Service::call(unsigned interface_no, unsigned function_no, int client_fd, saftbus::Deserializer &received, saftbus::Serializer &send) {
 		try {
 		switch(interface_no) {
 			case 0: // Container
 			switch(function_no) {
-				case 0: { // Container::register_proxy (Hand-written. It will be called by Poxy base class constructor)
+				case container_function::register_proxy: { // Container::register_proxy (Hand-written. It will be called by Poxy base class constructor)
 					std::string object_path;
 					received.get(object_path);
 					std::vector<std::string> interface_names;
@@ -256,7 +322,7 @@ namespace saftbus {
 					send.put(signal_fd); // send the integer value of the signal_fd back to the proxy. This nuber can be used by other Proxies to reuse the signal pipe.
 					send.put(interface_name2no_map);
 				} return;
-				case 1: { // Container::unregister_proxy (Hand-written. It will be called by Proxy base class destructor)
+				case container_function::unregister_proxy: { // Container::unregister_proxy (Hand-written. It will be called by Proxy base class destructor)
 					unsigned saftbus_object_id;
 					int received_client_fd, received_signal_group_fd;
 					received.get(saftbus_object_id);
@@ -264,7 +330,7 @@ namespace saftbus {
 					received.get(received_signal_group_fd);
 					d->unregister_proxy(saftbus_object_id, received_client_fd, received_signal_group_fd);
 				} return;
-				case 2: { // Container::load_plugin
+				case container_function::load_plugin: { // Container::load_plugin
 					std::string  so_filename;
 					received.get(so_filename);
 					std::vector<std::string> plugin_args;
@@ -273,7 +339,7 @@ namespace saftbus {
 					send.put(saftbus::FunctionResult::RETURN);
 					send.put(function_call_result);
 				} return;
-				case 3: { // Container::unload_plugin
+				case container_function::unload_plugin: { // Container::unload_plugin
 					std::string  so_filename;
 					received.get(so_filename);
 					std::vector<std::string> plugin_args;
@@ -282,7 +348,7 @@ namespace saftbus {
 					send.put(saftbus::FunctionResult::RETURN);
 					send.put(function_call_result);
 				} return;
-				case 4: { // Container::remove_object  // this is largely hand written, because we have to make sure that the destruction callback is correctly executed
+				case container_function::remove_object: { // Container::remove_object  // this is largely hand written, because we have to make sure that the destruction callback is correctly executed
 					std::string  object_path;
 					received.get(object_path);
 					bool function_call_result = true;
@@ -296,15 +362,79 @@ namespace saftbus {
 					send.put(saftbus::FunctionResult::RETURN);
 					send.put(function_call_result);
 				} return;
-				case 5: { // Container::quit
+				case container_function::quit: { // Container::quit
 					d->quit();
 					send.put(saftbus::FunctionResult::RETURN);
 				} return;
-				case 6: { // Container::get_status
+				case container_function::get_status: { // Container::get_status
 					SaftbusInfo function_call_result = d->get_status();
 					send.put(saftbus::FunctionResult::RETURN);
 					send.put(function_call_result);
 				} return;
+				case container_function::execute_batch: { // Container::execute_batch (Hand-written. It will be called by saftbus::Batch)
+					// The batch contains a number of nested requests. They are executed in sequence 
+					// and their replies are returned as nested replies in a single message.
+					unsigned num_calls;
+					received.get(num_calls);
+					saftbus::Deserializer calls;
+					received.get(calls);
+					send.put(saftbus::FunctionResult::RETURN);
+					send.put(num_calls);
+					saftbus::Deserializer call;
+					saftbus::Serializer reply;
+					for (unsigned i = 0; i < num_calls; ++i) {
+						calls.get(call);
+						uint32_t request_id;
+						unsigned saftbus_object_id;
+						call.get(request_id);
+						call.get(saftbus_object_id);
+						reply.put(request_id);
+						if (passes_fd(saftbus_object_id, call)) {
+							// the file descriptor of a nested call can't be matched to the call
+							reply.put(saftbus::FunctionResult::EXCEPTION);
+							std::string what("remote call cannot be part of a batch because it passes a file descriptor");
+							reply.put(what);
+						} else if (!d->call_service(saftbus_object_id, client_fd, call, reply)) {
+							reply.put(saftbus::FunctionResult::EXCEPTION);
+							std::string what("remote call failed because service object was not found");
+							reply.put(what);
+						}
+						send.put(reply);
+					}
+				} return;
+				case container_function::get_latency_histograms: { // Container::get_latency_histograms
+					std::map<std::string, std::vector<uint64_t> > function_call_result = d->get_latency_histograms();
+					send.put(saftbus::FunctionResult::RETURN);
+					send.put(function_call_result);
+				} return;
+				case container_function::set_latency_histograms: { // Container::set_latency_histograms
+					bool enable, reset;
+					received.get(enable);
+					received.get(reset);
+					d->set_latency_histograms(enable, reset);
+					send.put(saftbus::FunctionResult::RETURN);
+				} return;
+				case container_function::get_shared_fds: { // Container::get_shared_fds (Hand-written. The client sends a socket after the request, the file descriptors are sent back through it)
+					std::string object_path, name;
+					received.get(object_path);
+					received.get(name);
+					// The client sends the socket right after the request. Don't block all clients 
+					// if it doesn't: the client is dropped, because its next message can't be trusted.
+					int back_channel = recvfd(client_fd, back_channel_timeout_ms);
+					if (back_channel == -1) {
+						shutdown(client_fd, SHUT_RD); // the server sees the hang-up at the next read
+					}
+					unsigned num_fds = 0;
+					try {
+						num_fds = d->send_shared_fds(object_path, name, back_channel);
+					} catch (...) {
+						close(back_channel);
+						throw;
+					}
+					close(back_channel);
+					send.put(saftbus::FunctionResult::RETURN);
+					send.put(num_fds);
+				} return;
 			};
 
 		};
@@ -333,9 +463,10 @@ namespace saftbus {
 	Container::Container(ServerConnection *connection) 
 		: d(new Impl)
 	{
+		d->connection = connection; // must be set before the first object is created
+		d->loop = &Loop::get_default();
 		unsigned object_id = create_object("/saftbus", std::move(std::unique_ptr<Container_Service>(new Container_Service(this))));
 		assert(object_id == 1); // the entier system relies on having Container_Service at object_id 1	
-		d->connection = connection;
 		// d->active_service = nullptr;
 	}
 
@@ -345,12 +476,21 @@ namespace saftbus {
 
 	unsigned Container::create_object(const std::string &object_path, std::unique_ptr<Service> service)
 	{
+		if (d->in_other_thread()) {
+			// all calls of the Service will be executed in the LoopThread that created it
+			service->d->loop = &Loop::get_default();
+			unsigned saftbus_object_id = 0;
+			d->run_in_container_thread([&]() { saftbus_object_id = create_object(object_path, std::move(service)); });
+			return saftbus_object_id;
+		}
 		if (d->object_path_lookup_table.find(object_path) != d->object_path_lookup_table.end()) {
 			// we have already registered an object under this object path
 			return 0;
 		}
 		unsigned saftbus_object_id = d->generate_saftbus_object_id();
 		service->d->object_id = saftbus_object_id;
+		service->d->connection = d->connection;
+		service->d->container = this;
 		auto insertion_result = d->objects.insert(std::make_pair(saftbus_object_id, std::move(service)));
 		auto  insertion_took_place  = insertion_result.second;
 		auto &inserted_object       = insertion_result.first->second; 
@@ -364,6 +504,11 @@ namespace saftbus {
 
 	Service* Container::get_object(const std::string &object_path)
 	{
+		if (d->in_other_thread()) {
+			Service *service = nullptr;
+			d->run_in_container_thread([&]() { service = get_object(object_path); });
+			return service;
+		}
 		auto find_result = d->object_path_lookup_table.find(object_path);
 		if (find_result == d->object_path_lookup_table.end()) {
 			std::string msg = "cannot get object because its object_path \"";
@@ -377,6 +522,29 @@ namespace saftbus {
 	}
 
 	void Container::destroy_service(Service *service) {
+		if (d->in_other_thread()) {
+			// The Service is removed in the thread of the Container. Its destruction in the 
+			// LoopThread has to wait until the current request is completed.
+			std::string object_path = service->d->object_path;
+			int client_id = get_calling_client_id();
+			d->loop->invoke([this, object_path, client_id]() {
+				ServerConnection::CallingClient calling_client(client_id);
+				auto find_result = d->object_path_lookup_table.find(object_path);
+				if (find_result == d->object_path_lookup_table.end()) {
+					return;
+				}
+				auto &service = d->objects[find_result->second];
+				try {
+					if (service->d->destruction_callback) {
+						run_in_service_thread(service->d->loop, service->d->destruction_callback);
+					}
+					remove_object(object_path);
+				} catch(std::runtime_error &e) {
+					std::cerr << "Exception in " << __FUNCTION__ << " : " << e.what() << std::endl;
+				}
+			});
+			return;
+		}
 		if (get_calling_client_id() != -1) {
 			d->removed_services.push_back(service);
 		} else {
@@ -439,10 +607,17 @@ namespace saftbus {
 
 	bool Container::remove_object(const std::string &object_path)
 	{
+		if (d->in_other_thread()) {
+			bool result = false;
+			d->run_in_container_thread([&]() { result = remove_object(object_path); });
+			return result;
+		}
 		removal_helper(object_path);
 		auto object_id = d->object_path_lookup_table[object_path];
+		std::unique_ptr<Service> removed = std::move(d->objects[object_id]);
 		d->object_path_lookup_table.erase(object_path);
 		d->objects.erase(object_id);
+		run_in_service_thread(removed->d->loop, [&]() { removed.reset(); });
 		return false;
 	}
 
@@ -488,11 +663,18 @@ namespace saftbus {
 			return false;
 		}
 		auto &service = find_result->second;
-		service->call(client_fd, received, send);
+		if (service->d->loop) {
+			service->d->loop->invoke_and_wait([&]() {
+				ServerConnection::CallingClient calling_client(client_fd);
+				service->call(client_fd, received, send);
+			});
+		} else {
+			service->call(client_fd, received, send);
+		}
 
 		for (auto &s: d->removed_services) {
 			if (s->d->destruction_callback) {
-				s->d->destruction_callback();
+				run_in_service_thread(s->d->loop, s->d->destruction_callback);
 			}
 			try {
 				remove_object(s->d->object_path);
@@ -505,6 +687,38 @@ namespace saftbus {
 		return true;
 	}
 
+	bool Container::runs_in_loop_thread(unsigned saftbus_object_id) {
+		auto find_result = d->objects.find(saftbus_object_id);
+		return find_result != d->objects.end() && find_result->second->d->loop != nullptr;
+	}
+
+	bool Container::call_service_in_loop(unsigned saftbus_object_id, int client_fd, Deserializer &received, std::shared_ptr<Serializer> send, std::function<void()> done) {
+		auto find_result = d->objects.find(saftbus_object_id);
+		if (find_result == d->objects.end() || !find_result->second->d->loop) {
+			return false;
+		}
+		// The Service may be removed before the call is executed, e.g. by a Container function that
+		// runs in the LoopThread while the LoopThread waits for the Container. Services of a LoopThread
+		// are destroyed in that LoopThread, so the weak_ptr can be checked there without a race.
+		std::weak_ptr<Service> weak_service = find_result->second->d->self;
+		std::shared_ptr<Deserializer> request(new Deserializer);
+		request->swap(received);
+		Loop *container_loop = d->loop;
+		find_result->second->d->loop->invoke([weak_service, client_fd, request, send, done, container_loop]() {
+			std::shared_ptr<Service> service = weak_service.lock();
+			if (service) {
+				ServerConnection::CallingClient calling_client(client_fd);
+				service->call(client_fd, *request, *send);
+			} else {
+				send->put(saftbus::FunctionResult::EXCEPTION);
+				std::string what("remote call failed because service object was not found");
+				send->put(what);
+			}
+			container_loop->invoke(done);
+		});
+		return true;
+	}
+
 	void Container::remove_signal_fd(int fd)
 	{
 		for(auto &service: d->objects) {
@@ -513,6 +727,19 @@ namespace saftbus {
 	}
 
 
+	void Container::signal_dropped(unsigned saftbus_object_id, int signal_fd)
+	{
+		auto find_result = d->objects.find(saftbus_object_id);
+		if (find_result == d->objects.end()) {
+			return;
+		}
+		auto &fds = find_result->second->d->signal_fds_use_count_and_dropped_signals;
+		auto fd_use_count_dropped = fds.find(signal_fd);
+		if (fd_use_count_dropped != fds.end()) {
+			++fd_use_count_dropped->second.second;
+		}
+	}
+
 	// operator is used to std::find a Service based on owner, where the owner is identified by file descriptor (fd) of the client socket
 	bool operator==(std::pair<const unsigned int, std::unique_ptr<saftbus::Service> > &p, const int fd) {
 		return p.second->d->owner == fd;
@@ -531,7 +758,7 @@ namespace saftbus {
 				break;
 			}
 			if (iter->second->d->destruction_callback) {
-				iter->second->d->destruction_callback();
+				run_in_service_thread(iter->second->d->loop, iter->second->d->destruction_callback);
 			}
 			if (iter->second->d->destruction_callback && iter->second->d->destroy_if_owner_quits) {
 				try {
@@ -598,6 +825,38 @@ namespace saftbus {
 	}
 
 
+	void Container::set_shared_fds(const std::string &object_path, const std::string &name, const std::vector<int> &fds) {
+		if (d->in_other_thread()) {
+			d->run_in_container_thread([&]() { set_shared_fds(object_path, name, fds); });
+			return;
+		}
+		if (fds.empty()) {
+			d->shared_fds.erase(std::make_pair(object_path, name));
+		} else {
+			d->shared_fds[std::make_pair(object_path, name)] = fds;
+		}
+	}
+
+	unsigned Container::send_shared_fds(const std::string &object_path, const std::string &name, int back_channel) {
+		auto find_result = d->shared_fds.find(std::make_pair(object_path, name));
+		if (find_result == d->shared_fds.end()) {
+			std::ostringstream msg;
+			msg << "object " << object_path << " does not share file descriptors \"" << name << "\"";
+			throw saftbus::Error(msg.str());
+		}
+		if (back_channel == -1) {
+			throw saftbus::Error("cannot receive socket for sending file descriptors");
+		}
+		unsigned num_fds = 0;
+		for (int fd: find_result->second) {
+			if (sendfd(back_channel, fd) <= 0) {
+				break;
+			}
+			++num_fds;
+		}
+		return num_fds;
+	}
+
 	SaftbusInfo Container::get_status() {
 		SaftbusInfo result;
 		for (auto &obj: d->objects) {
@@ -616,6 +875,8 @@ namespace saftbus {
 			client_info.process_id = client.process_id;
 			client_info.client_fd  = client.client_fd;
 			client_info.signal_fds = client.signal_fds;
+			client_info.pending_signals = client.pending_signals;
+			client_info.dropped_signals = client.dropped_signals;
 			result.client_infos.push_back(client_info);
 		}
 		for (auto &name_loader: d->plugins) {
@@ -628,5 +889,15 @@ namespace saftbus {
 		return result;
 	}
 
+	std::map<std::string, std::vector<uint64_t> > Container::get_latency_histograms() {
+		return LatencyHistogram::get_all();
+	}
+	void Container::set_latency_histograms(bool enable, bool reset) {
+		if (reset) {
+			LatencyHistogram::reset_all();
+		}
+		LatencyHistogram::enable(enable);
+	}
+
 
 }
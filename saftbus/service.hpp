@@ -23,6 +23,7 @@
 
 #include "saftbus.hpp"
 #include "server.hpp"
+#include "histogram.hpp"
 
 // for the SaftbusInfo type
 // @saftbus-export
@@ -123,6 +124,8 @@ namespace saftbus {
 		///         - the object id (type int) of the Service object in the saftbus::Container
 		///         - the interface number (type int) of the interface that sends the signal
 		///         - the signal number (type int) of the signal being sent.
+		///        Signals that cannot be written immediately are buffered by the ServerConnection.
+		///        If called from a LoopThread, the signal is handed to the Loop of the Container and sent from there.
 		void emit(Serializer &send);
 
 		// @brief get the object id of this Service object in a saftbus::Container
@@ -145,10 +148,16 @@ namespace saftbus {
 	/// Classes derived from Service can be stored here. One instance of Container is hold by 
 	/// the Connection object and all Service objects are available for remote Proxy objects to 
 	/// register and execute function calls through the Connection.
+	///
+	/// The Container is used in the thread that runs its Loop. Services can also be created from 
+	/// within a saftbus::LoopThread. The driver code of these Services (function calls, destruction 
+	/// callbacks, destructors) is always executed in the LoopThread that created them. Container functions 
+	/// called from a LoopThread are executed in the Loop of the Container.
 	class Container {
 		// @saftbus-default-object-path /saftbus
 		struct Impl; std::unique_ptr<Impl> d;
 		friend class Container_Service;
+		friend class Service;
 	public:
 		
 		/// @brief create a Container for saftbus::Service objects
@@ -162,9 +171,19 @@ namespace saftbus {
 		/// @brief remove info callback. Plugins should clean up their callbacks when being unloaded
 		void remove_additional_info_callback(const std::string &name);
 
+		/// @brief make file descriptors of a Service (e.g. shared memory) available to clients
+		///
+		/// Clients get duplicates of the file descriptors with Container_Proxy::get_shared_fds.
+		/// The Container does not take ownership. The entry has to be removed (with an empty 
+		/// fds vector) before the file descriptors are closed.
+		/// @param object_path the object path of the Service that provides the file descriptors
+		/// @param name identifies the set of file descriptors of that object
+		/// @param fds the file descriptors, an empty vector removes the entry
+		void set_shared_fds(const std::string &object_path, const std::string &name, const std::vector<int> &fds);
+
 		/// @brief Insert a Service object and return the saftbus_object_id for this object
 		/// @param object_path the object path under which the Service object is available to Proxy objects.
-		/// @param service A Service object
+		/// @param service A Service object. If created from a LoopThread, all calls of the Service are executed in that LoopThread.
 		/// @return 0 in case the object_path is already used by another Service object. 
 		///         The object_id if the Service object was successfully inserted into the Container
 		unsigned create_object(const std::string &object_path, std::unique_ptr<Service> service);
@@ -186,8 +205,26 @@ namespace saftbus {
 		/// @param send     serialized return values that will be sent back to the client
 		/// @return false if the saftbus_object_id is unknown
 		bool call_service(unsigned saftbus_object_id, int client_fd, Deserializer &received, Serializer &send);
+
+		/// @brief check if a Service was created in a LoopThread
+		/// @return true if calls to the Service are executed in a LoopThread, false otherwise or if the Service was not found
+		bool runs_in_loop_thread(unsigned saftbus_object_id);
+
+		/// @brief call a Service that was created in a LoopThread without waiting for the result
+		/// @param saftbus_object_id identifies the service object
+		/// @param client_fd the file descriptor to the calling client
+		/// @param received data that came from the client. The content is moved into the LoopThread.
+		/// @param send     takes the serialized return values in the LoopThread 
+		/// @param done     is called in the Loop of the Container after send was filled
+		/// @return false if the Service is not executed in a LoopThread (or not found), use call_service in this case.
+		bool call_service_in_loop(unsigned saftbus_object_id, int client_fd, Deserializer &received, std::shared_ptr<Serializer> send, std::function<void()> done);
 		void remove_signal_fd(int fd);
 
+		/// @brief count a signal of service saftbus_object_id that was not delivered to signal_fd
+		/// @param saftbus_object_id identifies the service object that emitted the signal
+		/// @param signal_fd the signal file descriptor that the signal was dropped for
+		void signal_dropped(unsigned saftbus_object_id, int signal_fd);
+
 		/// @brief iterate all owned services and remove the ones previously owned by client with this fd
 		/// @param fd the file descriptor that signaled a hung-up condition
 		void client_hung_up(int fd);
@@ -233,6 +270,20 @@ namespace saftbus {
 
 		// @saftbus-export
 		SaftbusInfo get_status();
+
+		/// @brief bins of all registered LatencyHistograms (see histogram.hpp)
+		// @saftbus-export
+		std::map<std::string, std::vector<uint64_t> > get_latency_histograms();
+		/// @brief switch recording of LatencyHistograms on or off
+		/// @param enable true to start recording, false to stop recording
+		/// @param reset clear all histograms
+		// @saftbus-export
+		void set_latency_histograms(bool enable, bool reset);
+
+		/// @brief send the file descriptors registered with set_shared_fds through back_channel (one sendfd per file descriptor)
+		/// @return the number of file descriptors that were sent
+		// @saftbus-export (hand-written, the Proxy side is Container_Proxy::get_shared_fds)
+		unsigned send_shared_fds(const std::string &object_path, const std::string &name, int back_channel);
 	};
 
 	/// @brief created by saftbus-gen from class Container and copied here
@@ -0,0 +1,245 @@
+/*  Copyright (C) 2011-2016, 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *  @author Wesley W. Terpstra <w.terpstra@gsi.de>
+ *          Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#include "ActionFile.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+namespace saftlib {
+
+static const char     ACTION_FILE_MAGIC[8]  = {'S','A','F','T','A','C','T','1'};
+static const uint32_t ACTION_FILE_VERSION   = 1;
+static const size_t   ACTION_FILE_BUFFER    = 4096; // records
+
+static void write_all(int fd, const void *data, size_t size, const std::string &filename)
+{
+	const char *ptr = static_cast<const char*>(data);
+	while (size) {
+		ssize_t result = ::write(fd, ptr, size);
+		if (result < 0 && errno == EINTR) {
+			continue;
+		}
+		if (result <= 0) {
+			throw std::runtime_error("cannot write to " + filename + ": " + strerror(errno));
+		}
+		ptr  += result;
+		size -= result;
+	}
+}
+
+
+ActionFileWriter::ActionFileWriter(const std::string &filename_, uint64_t event_id, uint64_t event_mask, int64_t offset, uint32_t index_interval)
+	: filename(filename_)
+{
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ACTION_FILE_MAGIC, sizeof(header.magic));
+	header.version        = ACTION_FILE_VERSION;
+	header.record_size    = sizeof(ActionFileRecord);
+	header.index_interval = index_interval ? index_interval : 1;
+	header.event_id       = event_id;
+	header.event_mask     = event_mask;
+	header.offset         = offset;
+	fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1) {
+		throw std::runtime_error("cannot create " + filename + ": " + strerror(errno));
+	}
+	// num_records stays 0 until close(), so an incomplete file can be recognized
+	write_all(fd, &header, sizeof(header), filename);
+	buffer.reserve(ACTION_FILE_BUFFER);
+}
+
+ActionFileWriter::~ActionFileWriter()
+{
+	try {
+		close();
+	} catch (std::exception &) {
+		// nothing we can do here, the records are still readable without the index
+	}
+}
+
+void ActionFileWriter::write(const ActionRecord &action)
+{
+	if (header.num_records % header.index_interval == 0) {
+		ActionFileIndexEntry entry;
+		entry.executed = action.executed.getTAI();
+		entry.record   = header.num_records;
+		index.push_back(entry);
+	}
+	ActionFileRecord record;
+	memset(&record, 0, sizeof(record));
+	record.event    = action.event;
+	record.param    = action.param;
+	record.deadline = action.deadline.getTAI();
+	record.executed = action.executed.getTAI();
+	record.flags    = action.flags;
+	buffer.push_back(record);
+	++header.num_records;
+	if (buffer.size() >= ACTION_FILE_BUFFER) {
+		flush();
+	}
+}
+
+void ActionFileWriter::flush()
+{
+	if (fd == -1 || buffer.empty()) {
+		return;
+	}
+	write_all(fd, buffer.data(), buffer.size()*sizeof(ActionFileRecord), filename);
+	buffer.clear();
+}
+
+void ActionFileWriter::close()
+{
+	if (fd == -1) {
+		return;
+	}
+	flush();
+	header.index_offset      = sizeof(ActionFileHeader) + header.num_records*sizeof(ActionFileRecord);
+	header.num_index_entries = index.size();
+	if (!index.empty()) {
+		write_all(fd, index.data(), index.size()*sizeof(ActionFileIndexEntry), filename);
+	}
+	bool header_ok = pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+	::close(fd);
+	fd = -1;
+	if (!header_ok) {
+		throw std::runtime_error("cannot complete header of " + filename + ": " + strerror(errno));
+	}
+}
+
+uint64_t ActionFileWriter::size() const
+{
+	return header.num_records;
+}
+
+
+ActionFileReader::ActionFileReader(const std::string &filename)
+	: region(nullptr), mapped_size(0), header(nullptr), records(nullptr), num_records(0), index(nullptr), num_index_entries(0)
+{
+	int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		throw std::runtime_error("cannot open " + filename + ": " + strerror(errno));
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ActionFileHeader)) {
+		::close(fd);
+		throw std::runtime_error(filename + " is not an action file");
+	}
+	mapped_size = st.st_size;
+	void *map = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) {
+		throw std::runtime_error("cannot map " + filename + ": " + strerror(errno));
+	}
+	region  = static_cast<const char*>(map);
+	header  = reinterpret_cast<const ActionFileHeader*>(region);
+	records = reinterpret_cast<const ActionFileRecord*>(region + sizeof(ActionFileHeader));
+	if (memcmp(header->magic, ACTION_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+	    header->version != ACTION_FILE_VERSION || header->record_size != sizeof(ActionFileRecord)) {
+		munmap(const_cast<char*>(region), mapped_size);
+		throw std::runtime_error(filename + " is not an action file of version " + std::to_string(ACTION_FILE_VERSION));
+	}
+	uint64_t records_in_file = (mapped_size - sizeof(ActionFileHeader)) / sizeof(ActionFileRecord);
+	if (header->num_records == 0 || header->index_offset == 0) {
+		// the recording was not closed properly, use all complete records in the file
+		num_records = records_in_file;
+	} else {
+		num_records = std::min<uint64_t>(header->num_records, records_in_file);
+		// the index follows the records; a corrupt index must not lead to reads outside of the file
+		uint64_t index_offset = header->index_offset;
+		if (index_offset < sizeof(ActionFileHeader) + num_records*sizeof(ActionFileRecord) || 
+		    index_offset % alignof(ActionFileIndexEntry) != 0 || index_offset > mapped_size ||
+		    header->num_index_entries > (mapped_size - index_offset) / sizeof(ActionFileIndexEntry)) {
+			munmap(const_cast<char*>(region), mapped_size);
+			throw std::runtime_error(filename + " is truncated or has a corrupt index");
+		}
+		index             = reinterpret_cast<const ActionFileIndexEntry*>(region + index_offset);
+		num_index_entries = header->num_index_entries;
+		for (uint64_t i = 0; i < num_index_entries; ++i) {
+			if (index[i].record > num_records || 
+			    (i > 0 && (index[i].record < index[i-1].record || index[i].executed < index[i-1].executed))) {
+				munmap(const_cast<char*>(region), mapped_size);
+				throw std::runtime_error(filename + " has a corrupt index");
+			}
+		}
+	}
+}
+
+ActionFileReader::~ActionFileReader()
+{
+	munmap(const_cast<char*>(region), mapped_size);
+}
+
+const ActionFileHeader &ActionFileReader::get_header() const
+{
+	return *header;
+}
+
+uint64_t ActionFileReader::size() const
+{
+	return num_records;
+}
+
+const ActionFileRecord &ActionFileReader::operator[](uint64_t i) const
+{
+	return records[i];
+}
+
+ActionRecord ActionFileReader::get(uint64_t i) const
+{
+	ActionRecord action{};
+	action.event    = records[i].event;
+	action.param    = records[i].param;
+	action.deadline = makeTimeTAI(records[i].deadline);
+	action.executed = makeTimeTAI(records[i].executed);
+	action.flags    = records[i].flags;
+	return action;
+}
+
+uint64_t ActionFileReader::find(uint64_t executed_tai) const
+{
+	// narrow the search to the records between two index entries
+	uint64_t first = 0, last = num_records;
+	if (num_index_entries) {
+		const ActionFileIndexEntry *end   = index + num_index_entries;
+		const ActionFileIndexEntry *entry = std::lower_bound(index, end, executed_tai,
+			[](const ActionFileIndexEntry &e, uint64_t t) { return e.executed < t; });
+		if (entry != end) {
+			last = std::min(last, entry->record);
+		}
+		if (entry != index) {
+			first = (entry-1)->record;
+		}
+	}
+	const ActionFileRecord *record = std::lower_bound(records + first, records + last, executed_tai,
+		[](const ActionFileRecord &r, uint64_t t) { return r.executed < t; });
+	return record - records;
+}
+
+}
@@ -0,0 +1,129 @@
+/*  Copyright (C) 2011-2016, 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *  @author Wesley W. Terpstra <w.terpstra@gsi.de>
+ *          Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#ifndef SAFTLIB_ACTION_FILE_HPP_
+#define SAFTLIB_ACTION_FILE_HPP_
+
+#include "ActionRecord.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace saftlib {
+
+	/// @brief Binary file format for recorded actions (written by saft-record, read by saft-replay)
+	///
+	/// The file consists of
+	///   - one ActionFileHeader
+	///   - num_records ActionFileRecords in the order they were received
+	///   - num_index_entries ActionFileIndexEntries, one for every index_interval-th record
+	///
+	/// All values are in host byte order, times are TAI in nanoseconds.
+	/// The header is completed when the file is closed. If the recorder was killed, num_records
+	/// is 0 and there is no index. ActionFileReader then takes the records from the file size.
+	struct ActionFileHeader {
+		char     magic[8];          // "SAFTACT1"
+		uint32_t version;
+		uint32_t record_size;       // sizeof(ActionFileRecord)
+		uint64_t num_records;
+		uint64_t index_offset;      // file offset of the index, 0 if there is none
+		uint64_t num_index_entries;
+		uint32_t index_interval;
+		uint32_t reserved;
+		uint64_t event_id;          // the condition that was used for the recording
+		uint64_t event_mask;
+		int64_t  offset;
+	};
+
+	struct ActionFileRecord {
+		uint64_t event;
+		uint64_t param;
+		uint64_t deadline;
+		uint64_t executed;
+		uint16_t flags;
+		uint16_t reserved[3];
+	};
+
+	struct ActionFileIndexEntry {
+		uint64_t executed;          // execution time of the record
+		uint64_t record;            // record number
+	};
+
+	/// @brief Append actions to a new file. Writes are buffered.
+	class ActionFileWriter {
+	public:
+		/// @param filename       the file is created or truncated
+		/// @param event_id       condition of the recording, stored in the header
+		/// @param event_mask     condition of the recording, stored in the header
+		/// @param offset         condition of the recording, stored in the header
+		/// @param index_interval every index_interval-th record is put into the index
+		ActionFileWriter(const std::string &filename, uint64_t event_id = 0, uint64_t event_mask = 0, int64_t offset = 0, uint32_t index_interval = 4096);
+		/// @brief calls close()
+		~ActionFileWriter();
+		void write(const ActionRecord &action);
+		/// @brief write the buffered records to the file
+		void flush();
+		/// @brief flush, append the index, and complete the header
+		void close();
+		/// @brief number of records written so far
+		uint64_t size() const;
+	private:
+		ActionFileWriter(const ActionFileWriter&) = delete;
+		ActionFileWriter& operator=(const ActionFileWriter&) = delete;
+		std::string filename;
+		int fd;
+		ActionFileHeader header;
+		std::vector<ActionFileRecord> buffer;
+		std::vector<ActionFileIndexEntry> index;
+	};
+
+	/// @brief Read-only access to a file of recorded actions. The file is mapped into memory.
+	class ActionFileReader {
+	public:
+		/// @brief throws std::runtime_error if the file is not an action file, or if its index is truncated or corrupt
+		ActionFileReader(const std::string &filename);
+		~ActionFileReader();
+		const ActionFileHeader &get_header() const;
+		uint64_t size() const;
+		const ActionFileRecord &operator[](uint64_t i) const;
+		ActionRecord get(uint64_t i) const;
+		/// @brief number of the first record that was executed at or after executed_tai
+		///
+		/// Assumes that the records are ordered by execution time, as they are delivered
+		/// by one SoftwareActionSink. Returns size() if there is no such record.
+		uint64_t find(uint64_t executed_tai) const;
+	private:
+		ActionFileReader(const ActionFileReader&) = delete;
+		ActionFileReader& operator=(const ActionFileReader&) = delete;
+		const char *region;
+		size_t mapped_size;
+		const ActionFileHeader *header;
+		const ActionFileRecord *records;
+		uint64_t num_records;
+		const ActionFileIndexEntry *index;
+		uint64_t num_index_entries;
+	};
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+/*  Copyright (C) 2011-2016, 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *  @author Wesley W. Terpstra <w.terpstra@gsi.de>
+ *          Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#ifndef SAFTLIB_ACTION_RECORD_HPP_
+#define SAFTLIB_ACTION_RECORD_HPP_
+
+#include "Time.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace saftlib {
+
+	/// @brief One action as it is delivered by SoftwareCondition::SigActions.
+	///
+	/// The struct is passed through saftbus and shared memory as plain memory. Don't add members
+	/// that are not trivially copyable. Create it with "ActionRecord action{};" so that reserved
+	/// is zero; the explicit padding makes sure that no uninitialized bytes leave saftbusd.
+	struct ActionRecord {
+		uint64_t event;
+		uint64_t param;
+		Time     deadline;
+		Time     executed;
+		uint16_t flags;
+		uint16_t reserved[3];
+	};
+	static_assert(sizeof(ActionRecord) == 40, "ActionRecord must not have implicit padding");
+
+	/// @brief Adapter from SigActions to a per-action callback.
+	///
+	/// Existing SigAction handlers can be used with batched delivery:
+	///
+	///   condition->SigActions.connect(saftlib::for_each_action(&on_action));
+	///
+	/// where on_action has the same signature as a SigAction handler.
+	inline std::function<void(std::vector<ActionRecord>)> for_each_action(std::function<void(uint64_t event, uint64_t param, Time deadline, Time executed, uint16_t flags)> slot)
+	{
+		return [slot](std::vector<ActionRecord> actions) {
+			for (auto &action: actions) {
+				slot(action.event, action.param, action.deadline, action.executed, action.flags);
+			}
+		};
+	}
+
+}
+
+#endif
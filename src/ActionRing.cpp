@@ -0,0 +1,179 @@
+/*  Copyright (C) 2011-2016, 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *  @author Wesley W. Terpstra <w.terpstra@gsi.de>
+ *          Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#include "ActionRing.hpp"
+
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <chrono>
+
+namespace saftlib {
+
+ActionRing::ActionRing(size_t capacity)
+	: head(0), tail_cache(0), dropped(0)
+	, tail(0), head_cache(0), waiting(false)
+{
+	size_t size = 1;
+	while (size < capacity) size <<= 1;
+	slots.resize(size);
+	mask = size-1;
+	fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd == -1) {
+		throw std::runtime_error(std::string("ActionRing: cannot create eventfd: ") + strerror(errno));
+	}
+}
+
+ActionRing::~ActionRing()
+{
+	close(fd);
+}
+
+bool ActionRing::push(const ActionRecord &action)
+{
+	size_t h = head.load(std::memory_order_relaxed);
+	if (h - tail_cache == slots.size()) {
+		tail_cache = tail.load(std::memory_order_acquire);
+		if (h - tail_cache == slots.size()) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+	}
+	slots[h & mask] = action;
+	head.store(h+1, std::memory_order_release);
+	return true;
+}
+
+void ActionRing::notify()
+{
+	// pairs with the fence in arm(): either the consumer sees the new head, or we see waiting==true
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waiting.load(std::memory_order_relaxed) && waiting.exchange(false)) {
+		uint64_t one = 1;
+		if (write(fd, &one, sizeof(one)) < 0) {
+			// EAGAIN: the eventfd counter is saturated, so it is readable anyway
+		}
+	}
+}
+
+bool ActionRing::pop(ActionRecord &action)
+{
+	size_t t = tail.load(std::memory_order_relaxed);
+	if (t == head_cache) {
+		head_cache = head.load(std::memory_order_acquire);
+		if (t == head_cache) {
+			return false;
+		}
+	}
+	action = slots[t & mask];
+	tail.store(t+1, std::memory_order_release);
+	return true;
+}
+
+size_t ActionRing::pop(ActionRecord *actions, size_t max)
+{
+	size_t t = tail.load(std::memory_order_relaxed);
+	if (head_cache - t < max) {
+		head_cache = head.load(std::memory_order_acquire);
+	}
+	size_t n = std::min(head_cache - t, max);
+	for (size_t i = 0; i < n; ++i) {
+		actions[i] = slots[(t+i) & mask];
+	}
+	if (n) {
+		tail.store(t+n, std::memory_order_release);
+	}
+	return n;
+}
+
+bool ActionRing::arm()
+{
+	waiting.store(true, std::memory_order_seq_cst);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!empty()) {
+		waiting.store(false, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+void ActionRing::disarm()
+{
+	waiting.store(false, std::memory_order_relaxed);
+	uint64_t count;
+	while (read(fd, &count, sizeof(count)) == sizeof(count)); // fd is nonblocking
+}
+
+bool ActionRing::wait(int timeout_ms)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+	while (empty()) {
+		int remaining_ms = -1;
+		if (timeout_ms >= 0) {
+			auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+			if (remaining.count() < 0) {
+				return false;
+			}
+			remaining_ms = remaining.count();
+		}
+		if (arm()) {
+			struct pollfd pfd;
+			pfd.fd = fd;
+			pfd.events = POLLIN;
+			// the eventfd may carry a stale notification from an earlier arm(),
+			// so a wakeup doesn't guarantee that the ring is not empty
+			int result = poll(&pfd, 1, remaining_ms);
+			disarm();
+			if (result == 0) {
+				return !empty();
+			}
+		}
+	}
+	return true;
+}
+
+int ActionRing::get_fd() const
+{
+	return fd;
+}
+
+bool ActionRing::empty() const
+{
+	return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+}
+
+size_t ActionRing::capacity() const
+{
+	return slots.size();
+}
+
+uint64_t ActionRing::get_dropped() const
+{
+	return dropped.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,105 @@
+/*  Copyright (C) 2011-2016, 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *  @author Wesley W. Terpstra <w.terpstra@gsi.de>
+ *          Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#ifndef SAFTLIB_ACTION_RING_HPP_
+#define SAFTLIB_ACTION_RING_HPP_
+
+#include "ActionRecord.hpp"
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace saftlib {
+
+	/// @brief Lock-free single-producer single-consumer ring of actions.
+	///
+	/// Only useful for standalone programs (without saftbusd) that use the driver
+	/// classes directly. The producer is the thread that runs the saftbus::Loop
+	/// of the SoftwareActionSink (see SoftwareActionSink::setActionRing), the consumer
+	/// is exactly one user thread, which may run on a dedicated core. The consumer
+	/// can busy-poll with pop(), block with wait(), or put get_fd() into its own
+	/// poll/epoll set after a successful arm().
+	///
+	/// If the ring is full, new actions are dropped and counted (see get_dropped()).
+	class ActionRing {
+	public:
+		/// @param capacity is rounded up to the next power of two
+		ActionRing(size_t capacity = 4096);
+		~ActionRing();
+
+		// producer side (the thread that runs the saftbus::Loop)
+
+		/// @brief append one action. Returns false (and counts the action as dropped) if the ring is full.
+		bool push(const ActionRecord &action);
+		/// @brief wake up the consumer if it waits. Call after a number of push() calls.
+		void notify();
+
+		// consumer side (one user thread)
+
+		/// @brief take one action out of the ring. Returns false if the ring is empty.
+		bool pop(ActionRecord &action);
+		/// @brief take up to max actions out of the ring. Returns the number of actions.
+		size_t pop(ActionRecord *actions, size_t max);
+		/// @brief block until the ring is not empty or the timeout expires.
+		/// @param timeout_ms the timeout in milliseconds, -1 blocks forever
+		/// @return true if actions are available
+		bool wait(int timeout_ms = -1);
+		/// @brief announce that the consumer is about to wait on get_fd().
+		/// @return false if there are already actions in the ring; don't wait in this case.
+		///
+		/// The file descriptor becomes readable as soon as an action is pushed after arm()
+		/// returned true. Call disarm() after it became readable (or the wait was aborted).
+		bool arm();
+		void disarm();
+		/// @brief an eventfd that is readable after arm() when actions are available
+		int get_fd() const;
+
+		bool empty() const;
+		size_t capacity() const;
+		/// @brief number of actions that were dropped because the ring was full
+		uint64_t get_dropped() const;
+
+	private:
+		ActionRing(const ActionRing&) = delete;
+		ActionRing& operator=(const ActionRing&) = delete;
+
+		// Producer and consumer state are kept in separate cache lines
+		// to avoid false sharing between the two threads.
+		static const size_t CACHE_LINE = 64;
+
+		alignas(CACHE_LINE) std::atomic<size_t> head; // next slot to write, written by producer
+		size_t tail_cache;                            // producer's last view of tail
+		std::atomic<uint64_t> dropped;
+
+		alignas(CACHE_LINE) std::atomic<size_t> tail; // next slot to read, written by consumer
+		size_t head_cache;                            // consumer's last view of head
+		std::atomic<bool> waiting;
+
+		alignas(CACHE_LINE) std::vector<ActionRecord> slots;
+		size_t mask;
+		int fd;
+	};
+
+}
+
+#endif
@@ -306,14 +306,14 @@ void ActionSink::receiveMSI(uint8_t code)
 	// std::cerr << "ActionSink::receiveMSI(" << code << ")" << std::endl;
 	std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
 	std::chrono::steady_clock::time_point exec; 
-	std::chrono::milliseconds interval(0);
+	std::chrono::nanoseconds interval(0);
 
 	switch (code) {
 	case ECA_OVERFLOW:
 		//DRIVER_LOG("ECA_OVERFLOW",-1, -1);
 		saftbus::Loop::get_default().remove(overflowPending); // just to be safe
 		exec = overflowUpdate + signalRate;
-		if (exec > time) interval = std::chrono::duration_cast<std::chrono::milliseconds>(exec-time);
+		if (exec > time) interval = std::chrono::duration_cast<std::chrono::nanoseconds>(exec-time);
 		overflowPending = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
 			std::bind(&ActionSink::updateOverflow, this),interval,interval);
 		break;
@@ -321,7 +321,7 @@ void ActionSink::receiveMSI(uint8_t code)
 		//DRIVER_LOG("ECA_VALID",-1, -1);
 		saftbus::Loop::get_default().remove(actionPending); // just to be safe
 		exec = actionUpdate + signalRate;
-		if (exec > time) interval = std::chrono::duration_cast<std::chrono::milliseconds>(exec-time);
+		if (exec > time) interval = std::chrono::duration_cast<std::chrono::nanoseconds>(exec-time);
 		actionPending = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
 			std::bind(&ActionSink::updateAction, this),interval,interval);
 		break;
@@ -329,7 +329,7 @@ void ActionSink::receiveMSI(uint8_t code)
 		//DRIVER_LOG("ECA_LATE",-1, -1);
 		saftbus::Loop::get_default().remove(latePending); // just to be safe
 		exec = lateUpdate + signalRate;
-		if (exec > time) interval = std::chrono::duration_cast<std::chrono::milliseconds>(exec-time);
+		if (exec > time) interval = std::chrono::duration_cast<std::chrono::nanoseconds>(exec-time);
 		latePending = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
 			std::bind(&ActionSink::updateLate, this),interval,interval);
 		break;
@@ -337,7 +337,7 @@ void ActionSink::receiveMSI(uint8_t code)
 		//DRIVER_LOG("ECA_EARLY",-1, -1);
 		saftbus::Loop::get_default().remove(earlyPending); // just to be safe
 		exec = earlyUpdate + signalRate;
-		if (exec > time) interval = std::chrono::duration_cast<std::chrono::milliseconds>(exec-time);
+		if (exec > time) interval = std::chrono::duration_cast<std::chrono::nanoseconds>(exec-time);
 		earlyPending = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
 			std::bind(&ActionSink::updateEarly, this),interval,interval);
 		break;
@@ -345,7 +345,7 @@ void ActionSink::receiveMSI(uint8_t code)
 		//DRIVER_LOG("ECA_CONFLICT",-1, -1);
 		saftbus::Loop::get_default().remove(conflictPending); // just to be safe
 		exec = conflictUpdate + signalRate;
-		if (exec > time) interval = std::chrono::duration_cast<std::chrono::milliseconds>(exec-time);
+		if (exec > time) interval = std::chrono::duration_cast<std::chrono::nanoseconds>(exec-time);
 		conflictPending = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
 			std::bind(&ActionSink::updateConflict, this),interval,interval);
 		break;
@@ -353,7 +353,7 @@ void ActionSink::receiveMSI(uint8_t code)
 		//DRIVER_LOG("ECA_DELAYED",-1, -1);
 		saftbus::Loop::get_default().remove(delayedPending); // just to be safe
 		exec = delayedUpdate + signalRate;
-		if (exec > time) interval = std::chrono::duration_cast<std::chrono::milliseconds>(exec-time);
+		if (exec > time) interval = std::chrono::duration_cast<std::chrono::nanoseconds>(exec-time);
 		delayedPending = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
 			std::bind(&ActionSink::updateDelayed, this),interval,interval);
 		break;
@@ -511,6 +511,57 @@ void ActionSink::removeCondition(Condition *condition)
 	}
 }
 
+std::vector< std::string > ActionSink::NewConditionsHelper(bool active, unsigned count, const std::vector<uint8_t> &accept_flags,
+                                                            const std::function<Condition*(unsigned)> &make_condition)
+{
+	if (!accept_flags.empty() && accept_flags.size() != count) {
+		throw saftbus::Error(saftbus::Error::INVALID_ARGS, "accept_flags must be empty or have one entry per condition");
+	}
+	std::vector<Condition*> created;
+	std::vector<std::string> paths;
+	try {
+		for (unsigned i = 0; i < count; ++i) {
+			// conditions are inactive until all of them exist => setAccept* does not compile
+			Condition *condition = make_condition(i);
+			created.push_back(condition);
+			if (!accept_flags.empty()) {
+				condition->setAcceptLate    (accept_flags[i] & (1<<ECA_LATE));
+				condition->setAcceptEarly   (accept_flags[i] & (1<<ECA_EARLY));
+				condition->setAcceptConflict(accept_flags[i] & (1<<ECA_CONFLICT));
+				condition->setAcceptDelayed (accept_flags[i] & (1<<ECA_DELAYED));
+			}
+			paths.push_back(condition->getObjectPath());
+		}
+		if (active) {
+			for (auto &condition: created) {
+				condition->setRawActive(true);
+			}
+			eca.compile();
+		}
+	} catch (...) {
+		// undo the changes
+		for (auto &condition: created) {
+			condition->setRawActive(false); // removal must not trigger a compile
+		}
+		for (auto &path: paths) {
+			if (container) {
+				try {
+					container->remove_object(path);
+				} catch (...) {
+					// nothing
+				}
+			}
+		}
+		if (!container) {
+			for (auto &condition: created) {
+				removeCondition(condition);
+			}
+		}
+		throw;
+	}
+	return paths;
+}
+
 void ActionSink::compile()
 {
 	// std::cerr << "ActionSink::compile()" << std::endl;
@@ -27,6 +27,7 @@
 #include <chrono>
 #include <vector>
 #include <string>
+#include <functional>
 
 #include <saftbus/loop.hpp>
 #include <saftbus/service.hpp>
@@ -485,24 +486,36 @@ class ActionSink : public Owned
 		// choose a random number that is not already used by another condition
 		unsigned createConditionNumber();
 
+		// create a condition (and its service object if running inside saftbusd) without compiling it into hardware
 		template<typename ConditionType, typename... Args>
-		std::string NewConditionHelper(bool active, Args&&... args) {
+		ConditionType *InsertConditionHelper(bool active, Args&&... args) {
 			unsigned number = createConditionNumber();
 			std::unique_ptr<ConditionType> condition(new ConditionType(this, number, active, std::forward<Args>(args)...));
-			std::string path = condition->getObjectPath();
+			ConditionType *result = condition.get();
 			if (container) {
 				std::unique_ptr<typename ConditionType::ServiceType> service(new typename ConditionType::ServiceType(condition.get(), std::bind(&ActionSink::removeCondition, this, condition.get())));
 				service->set_owner(container->get_calling_client_id());
 				condition->set_service(service.get());
-				container->create_object(path, std::move(service));
+				container->create_object(condition->getObjectPath(), std::move(service));
 			}
 			conditions.insert(std::make_pair(number, std::move(condition)));
+			return result;
+		}
+
+		template<typename ConditionType, typename... Args>
+		std::string NewConditionHelper(bool active, Args&&... args) {
+			std::string path = InsertConditionHelper<ConditionType>(active, std::forward<Args>(args)...)->getObjectPath();
 			if (active) {
 				eca.compile();
 			}
 			return path;
 		}
 
+		// Create many conditions with a single compile. Either all conditions are created or none.
+		// make_condition(i) has to create the i-th condition (inactive) using InsertConditionHelper.
+		std::vector< std::string > NewConditionsHelper(bool active, unsigned count, const std::vector<uint8_t> &accept_flags,
+		                                                const std::function<Condition*(unsigned)> &make_condition);
+
 
 	protected:
 		std::string object_path;
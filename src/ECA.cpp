@@ -327,6 +327,9 @@ struct SearchEntry {
 	uint64_t event;
 	int16_t  index;
 	SearchEntry(uint64_t e, int16_t i) : event(e), index(i) { }
+	bool operator==(const SearchEntry &rhs) const {
+		return event == rhs.event && index == rhs.index;
+	}
 };
 
 struct WalkEntry {
@@ -338,6 +341,20 @@ struct WalkEntry {
 	unsigned num;
 	WalkEntry(int16_t n, const ECA_OpenClose& oc) : next(n), 
 	offset(oc.offset), tag(oc.tag), flags(oc.flags), channel(oc.channel), num(oc.num) { }
+	bool operator==(const WalkEntry &rhs) const {
+		return next    == rhs.next    && offset  == rhs.offset && tag == rhs.tag 
+		    && flags   == rhs.flags   && channel == rhs.channel && num == rhs.num;
+	}
+};
+
+// What was written into one of the two hardware table banks.
+// If valid is false, the content of that bank is unknown and
+// the next compile has to write all rows of it.
+struct ECA::TableShadow {
+	bool valid;
+	std::vector<SearchEntry> search; // always search_size entries if valid
+	std::vector<WalkEntry>   walk;   // all walker entries ever written to this bank
+	TableShadow() : valid(false) {}
 };
 
 void ECA::ToggleActive()
@@ -510,24 +527,35 @@ void ECA::compile()
 // 		clog << kLogDebug << "W: " << walk[i].next << " " << walk[i].offset << " " << walk[i].tag << " " << walk[i].flags << " " << (int)walk[i].channel << " " << (int)walk[i].num << std::endl;
 // #endif
 
+	// Only rows that differ from what is already in the inactive bank are written, 
+	// all of them in one cycle. 
+	TableShadow &shadow = *table_shadow[inactive_table];
+	bool full_write = !shadow.valid;
+	shadow.valid = false; // in case the cycle fails, the content of the bank is unknown
+	shadow.search.reserve(search_size);
+
 	etherbone::Cycle cycle;
+	cycle.open(device);
 	for (unsigned i = 0; i < search_size; ++i) {
 		/* Duplicate last entry to fill out the table */
 		const SearchEntry& se = (i<search.size())?search[i]:search.back();
+		if (!full_write && se == shadow.search[i]) {
+			continue;
+		}
 		
-		cycle.open(device);
 		cycle.write(adr_first + ECA_SEARCH_SELECT_RW,      EB_DATA32, i);
 		cycle.write(adr_first + ECA_SEARCH_RW_FIRST_RW,    EB_DATA32, (uint16_t)se.index);
 		cycle.write(adr_first + ECA_SEARCH_RW_EVENT_HI_RW, EB_DATA32, se.event >> 32);
 		cycle.write(adr_first + ECA_SEARCH_RW_EVENT_LO_RW, EB_DATA32, (uint32_t)se.event);
 		cycle.write(adr_first + ECA_SEARCH_WRITE_OWR,      EB_DATA32, 1);
-		cycle.close();
 	}
 	
 	for (unsigned i = 0; i < walk.size(); ++i) {
 		const WalkEntry& we = walk[i];
+		if (!full_write && i < shadow.walk.size() && we == shadow.walk[i]) {
+			continue;
+		}
 		
-		cycle.open(device);
 		cycle.write(adr_first + ECA_WALKER_SELECT_RW,       EB_DATA32, i);
 		cycle.write(adr_first + ECA_WALKER_RW_NEXT_RW,      EB_DATA32, (uint16_t)we.next);
 		cycle.write(adr_first + ECA_WALKER_RW_OFFSET_HI_RW, EB_DATA32, (uint64_t)we.offset >> 32); // don't sign-extend on shift
@@ -537,11 +565,28 @@ void ECA::compile()
 		cycle.write(adr_first + ECA_WALKER_RW_CHANNEL_RW,   EB_DATA32, we.channel);
 		cycle.write(adr_first + ECA_WALKER_RW_NUM_RW,       EB_DATA32, we.num);
 		cycle.write(adr_first + ECA_WALKER_WRITE_OWR,       EB_DATA32, 1);
-		cycle.close();
 	}
+	cycle.close();
+
+	// Remember what is in the bank now. Walker entries beyond walk.size() 
+	// are unreferenced, but still in hardware and therefore kept in the shadow.
+	shadow.search.clear();
+	for (unsigned i = 0; i < search_size; ++i) {
+		shadow.search.push_back((i<search.size())?search[i]:search.back());
+	}
+	if (full_write) {
+		shadow.walk = walk;
+	} else {
+		for (unsigned i = 0; i < walk.size(); ++i) {
+			if (i < shadow.walk.size()) shadow.walk[i] = walk[i];
+			else                        shadow.walk.push_back(walk[i]);
+		}
+	}
+	shadow.valid = true;
 	
 	// Flip the tables
 	device.write(adr_first + ECA_FLIP_ACTIVE_OWR, EB_DATA32, 1);
+	inactive_table = 1 - inactive_table;
 	
 	used_conditions = id_space.size()/2;
 }
@@ -577,8 +622,11 @@ ECA::ECA(SAFTd &saftd, etherbone::Device &dev, const std::string &obj_path, saft
 	, object_path(obj_path)
 	, container(cont)
 	, sas_count(0)
+	, inactive_table(0)
 {
 	// std::cerr << "ECA::ECA() object_path " << object_path << std::endl;
+	table_shadow[0].reset(new TableShadow);
+	table_shadow[1].reset(new TableShadow);
 	probeConfiguration();
 	compile(); // remove old rules
 	prepareChannels();
@@ -61,6 +61,7 @@ class Output;
 /// Each invalid unique_ptr<ActionSink> indicates an un-occupied sub-channel. Each SoftwareActionSink can have many conditions. On execution, ECA writes a tag value into the ActionSink that refers to the condition that matched the incoming event.
 class ECA : public MsiDevice {
 	friend class ActionSink;
+	friend class SoftwareActionSink;
 
 	std::string        object_path;
 	saftbus::Container *container;
@@ -75,6 +76,12 @@ class ECA : public MsiDevice {
 	std::vector<eb_address_t> queue_addresses;
 	std::vector<uint16_t> most_full;
 
+	// The hardware has two banks of search/walk tables. compile() writes the inactive one and flips them.
+	// Shadow copies of both banks allow compile() to write only the rows that changed.
+	struct TableShadow;
+	std::unique_ptr<TableShadow> table_shadow[2];
+	unsigned inactive_table;
+
 
 	std::vector<std::unique_ptr<IRQ> > channel_irqs;
 
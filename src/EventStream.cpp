@@ -0,0 +1,426 @@
+/*  Copyright (C) 2011-2016, 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *  @author Wesley W. Terpstra <w.terpstra@gsi.de>
+ *          Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#include "EventStream.hpp"
+
+#include <saftbus/client.hpp>
+#include <saftbus/error.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+
+namespace saftlib {
+
+const char *event_stream_fd_name = "event-stream";
+
+static const uint32_t EVENT_STREAM_MAGIC       = 0x53414654; // "SAFT"
+static const uint32_t EVENT_STREAM_VERSION     = 2;
+static const unsigned EVENT_STREAM_MAX_READERS = 16;
+static const uint32_t EVENT_STREAM_MAX_CAPACITY = 1<<20;
+static const int64_t  EVENT_STREAM_LEASE_MS    = 10000;
+
+// The ring memfd starts with the header, the ring of EventStreamSlots follows.
+// It is written only by the EventStreamWriter, readers map it read-only.
+// The memfd is zero-initialized, which is a valid state for all atomics.
+struct EventStreamHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t capacity;
+	uint32_t max_readers;
+	std::atomic<uint32_t> closed;
+	alignas(64) std::atomic<uint64_t> head; // number of actions published so far
+};
+
+// The sequence number works like a seqlock: it is 0 while the action is written
+// and index+1 afterwards. Readers copy the action and check that seq didn't change.
+struct EventStreamSlot {
+	alignas(64) std::atomic<uint64_t> seq;
+	ActionRecord action; // has no implicit padding, the writer publishes only initialized bytes
+};
+
+// One per reader process (or thread), in a memfd of its own that readers can write.
+// The writer only reads and clears the waiting flags.
+struct EventStreamReaderSlot {
+	alignas(64) std::atomic<uint64_t> owner; // token of the reader, 0 if the slot is free
+	std::atomic<int64_t> lease_until;        // steady_clock in ms, the slot can be taken over afterwards
+	std::atomic<uint32_t> waiting;           // 1 while the reader waits on its eventfd
+};
+struct EventStreamReaders {
+	EventStreamReaderSlot slots[EVENT_STREAM_MAX_READERS];
+};
+
+static std::string errno_message(const char *what)
+{
+	std::ostringstream msg;
+	msg << what << ": " << strerror(errno);
+	return msg.str();
+}
+
+static int64_t now_ms()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// create a memfd of the given size that cannot be resized, otherwise any process 
+// with the file descriptor could make the mapping of the writer fault
+static int create_sealed_memfd(const char *name, size_t size)
+{
+	int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd == -1) {
+		throw saftbus::Error(errno_message("EventStream: cannot create memfd"));
+	}
+	if (ftruncate(fd, size) != 0 || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+		std::string msg = errno_message("EventStream: cannot prepare memfd");
+		close(fd);
+		throw saftbus::Error(msg);
+	}
+	return fd;
+}
+
+static void *map_fd(int fd, size_t size, int prot)
+{
+	void *region = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+	if (region == MAP_FAILED) {
+		throw saftbus::Error(errno_message("EventStream: cannot map shared memory"));
+	}
+	return region;
+}
+
+
+EventStreamWriter::EventStreamWriter(uint32_t capacity_)
+	: ring_fd(-1), header(nullptr), slots(nullptr), mapped_size(0), readers(nullptr), ring_capacity(1), ring_mask(0), head(0)
+{
+	while (ring_capacity < capacity_ && ring_capacity < EVENT_STREAM_MAX_CAPACITY) ring_capacity <<= 1;
+	ring_mask = ring_capacity-1;
+	mapped_size = sizeof(EventStreamHeader) + ring_capacity*sizeof(EventStreamSlot);
+
+	void *ring = MAP_FAILED;
+	void *state = MAP_FAILED;
+	try {
+		ring_fd = create_sealed_memfd("saftlib-event-stream", mapped_size);
+		ring = map_fd(ring_fd, mapped_size, PROT_READ | PROT_WRITE);
+		// readers get a read-only descriptor: they can neither write nor map the ring writable
+		std::ostringstream ring_path;
+		ring_path << "/proc/self/fd/" << ring_fd;
+		int ring_read_only_fd = open(ring_path.str().c_str(), O_RDONLY | O_CLOEXEC);
+		if (ring_read_only_fd == -1) {
+			throw saftbus::Error(errno_message("EventStream: cannot open read-only descriptor of memfd"));
+		}
+		fds.push_back(ring_read_only_fd);
+		fds.push_back(create_sealed_memfd("saftlib-event-stream-readers", sizeof(EventStreamReaders)));
+		state = map_fd(fds.back(), sizeof(EventStreamReaders), PROT_READ | PROT_WRITE);
+		for (unsigned i = 0; i < EVENT_STREAM_MAX_READERS; ++i) {
+			int wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (wakeup_fd == -1) {
+				throw saftbus::Error(errno_message("EventStream: cannot create eventfd"));
+			}
+			fds.push_back(wakeup_fd);
+		}
+	} catch (...) {
+		if (ring  != MAP_FAILED) munmap(ring, mapped_size);
+		if (state != MAP_FAILED) munmap(state, sizeof(EventStreamReaders));
+		if (ring_fd != -1) close(ring_fd);
+		for (int fd: fds) close(fd);
+		throw;
+	}
+	header  = static_cast<EventStreamHeader*>(ring);
+	slots   = reinterpret_cast<EventStreamSlot*>(header+1);
+	readers = static_cast<EventStreamReaders*>(state);
+	header->magic       = EVENT_STREAM_MAGIC;
+	header->version     = EVENT_STREAM_VERSION;
+	header->capacity    = ring_capacity;
+	header->max_readers = EVENT_STREAM_MAX_READERS;
+}
+
+EventStreamWriter::~EventStreamWriter()
+{
+	header->closed.store(1);
+	notify();
+	munmap(header, mapped_size);
+	munmap(readers, sizeof(EventStreamReaders));
+	close(ring_fd);
+	for (int fd: fds) {
+		close(fd);
+	}
+}
+
+void EventStreamWriter::push(const ActionRecord &action)
+{
+	// head and the ring size are private, nothing is read back from shared memory
+	uint64_t index = head++;
+	EventStreamSlot &slot = slots[index & ring_mask];
+	slot.seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.action = action;
+	slot.seq.store(index+1, std::memory_order_release);
+	header->head.store(head, std::memory_order_release);
+}
+
+void EventStreamWriter::notify()
+{
+	// pairs with the fence in EventStreamReader::arm()
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for (unsigned i = 0; i < EVENT_STREAM_MAX_READERS; ++i) {
+		std::atomic<uint32_t> &waiting = readers->slots[i].waiting;
+		if (waiting.load(std::memory_order_relaxed) && waiting.exchange(0)) {
+			uint64_t one = 1;
+			if (write(fds[2+i], &one, sizeof(one)) < 0) {
+				// EAGAIN: the eventfd counter is saturated, so it is readable anyway
+			}
+		}
+	}
+}
+
+const std::vector<int> &EventStreamWriter::get_fds() const
+{
+	return fds;
+}
+
+uint32_t EventStreamWriter::capacity() const
+{
+	return ring_capacity;
+}
+
+
+EventStreamReader::EventStreamReader(const std::vector<int> &fds_)
+	: fds(fds_), header(nullptr), slots(nullptr), mapped_size(0), readers(nullptr), reader_slot(0), token(0), lease_renewed(0), cursor(0), lost(0)
+{
+	const void *ring = MAP_FAILED;
+	void *state = MAP_FAILED;
+	try {
+		struct stat ring_st, state_st;
+		if (fds.size() != 2+EVENT_STREAM_MAX_READERS || 
+		    fstat(fds[0], &ring_st) != 0 || (size_t)ring_st.st_size < sizeof(EventStreamHeader) ||
+		    fstat(fds[1], &state_st) != 0 || (size_t)state_st.st_size != sizeof(EventStreamReaders)) {
+			throw saftbus::Error("EventStream: invalid shared memory file descriptors");
+		}
+		mapped_size = ring_st.st_size;
+		ring  = map_fd(fds[0], mapped_size, PROT_READ);
+		state = map_fd(fds[1], sizeof(EventStreamReaders), PROT_READ | PROT_WRITE);
+		header  = static_cast<const EventStreamHeader*>(ring);
+		slots   = reinterpret_cast<const EventStreamSlot*>(header+1);
+		readers = static_cast<EventStreamReaders*>(state);
+		if (header->magic != EVENT_STREAM_MAGIC || header->version != EVENT_STREAM_VERSION ||
+		    header->max_readers != EVENT_STREAM_MAX_READERS ||
+		    mapped_size < sizeof(EventStreamHeader) + header->capacity*sizeof(EventStreamSlot)) {
+			throw saftbus::Error("EventStream: incompatible shared memory layout");
+		}
+		std::random_device random;
+		while (token == 0) {
+			token = (static_cast<uint64_t>(random()) << 32) | random();
+		}
+		claim_slot();
+	} catch (...) {
+		if (ring  != MAP_FAILED) munmap(const_cast<void*>(ring), mapped_size);
+		if (state != MAP_FAILED) munmap(state, sizeof(EventStreamReaders));
+		for (int fd: fds) close(fd);
+		throw;
+	}
+	cursor = header->head.load(std::memory_order_acquire);
+}
+
+EventStreamReader::~EventStreamReader()
+{
+	EventStreamReaderSlot &slot = readers->slots[reader_slot];
+	uint64_t own_token = token;
+	slot.waiting.store(0);
+	slot.owner.compare_exchange_strong(own_token, 0); // unless the slot was taken over
+	munmap(const_cast<EventStreamHeader*>(header), mapped_size);
+	munmap(readers, sizeof(EventStreamReaders));
+	for (int fd: fds) {
+		close(fd);
+	}
+}
+
+// Take a free reader slot, or one whose lease expired if none is free. 
+// Leases work across PID namespaces, where the pid of another reader means nothing.
+void EventStreamReader::claim_slot()
+{
+	for (int pass = 0; pass < 2; ++pass) {
+		for (unsigned i = 0; i < EVENT_STREAM_MAX_READERS; ++i) {
+			EventStreamReaderSlot &slot = readers->slots[i];
+			uint64_t old_owner = slot.owner.load();
+			if (pass == 0 && old_owner != 0) {
+				continue;
+			}
+			if (pass == 1 && slot.lease_until.load() > now_ms()) {
+				continue;
+			}
+			if (slot.owner.compare_exchange_strong(old_owner, token)) {
+				reader_slot   = i;
+				lease_renewed = now_ms();
+				slot.lease_until.store(lease_renewed + EVENT_STREAM_LEASE_MS);
+				slot.waiting.store(0);
+				return;
+			}
+		}
+	}
+	throw saftbus::Error("EventStream: too many readers");
+}
+
+// returns false if the slot was taken over and a new one had to be claimed
+bool EventStreamReader::renew_lease()
+{
+	int64_t now = now_ms();
+	EventStreamReaderSlot &slot = readers->slots[reader_slot];
+	if (slot.owner.load() != token) {
+		claim_slot();
+		return false;
+	}
+	if (now - lease_renewed > EVENT_STREAM_LEASE_MS/4) {
+		lease_renewed = now;
+		slot.lease_until.store(now + EVENT_STREAM_LEASE_MS);
+	}
+	return true;
+}
+
+std::shared_ptr<EventStreamReader> EventStreamReader::create(const std::string &sink_object_path, std::shared_ptr<saftbus::Container_Proxy> container)
+{
+	if (!container) {
+		container = saftbus::Container_Proxy::create();
+	}
+	return std::make_shared<EventStreamReader>(container->get_shared_fds(sink_object_path, event_stream_fd_name));
+}
+
+bool EventStreamReader::pop(ActionRecord &action)
+{
+	return pop(&action, 1) == 1;
+}
+
+size_t EventStreamReader::pop(ActionRecord *actions, size_t max)
+{
+	uint64_t capacity = header->capacity;
+	size_t n = 0;
+	while (n < max) {
+		uint64_t head = header->head.load(std::memory_order_acquire);
+		if (cursor == head) {
+			break;
+		}
+		if (head - cursor > capacity) {
+			// the writer has overtaken us
+			lost  += head - cursor - capacity;
+			cursor = head - capacity;
+		}
+		const EventStreamSlot &slot = slots[cursor & (capacity-1)];
+		uint64_t seq = slot.seq.load(std::memory_order_acquire);
+		actions[n] = slot.action;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (seq != cursor+1 || slot.seq.load(std::memory_order_relaxed) != seq) {
+			// overwritten while we were reading it
+			++lost;
+			++cursor;
+			continue;
+		}
+		++cursor;
+		++n;
+	}
+	return n;
+}
+
+bool EventStreamReader::available() const
+{
+	return header->head.load(std::memory_order_acquire) != cursor || header->closed.load(std::memory_order_relaxed);
+}
+
+bool EventStreamReader::arm()
+{
+	renew_lease();
+	std::atomic<uint32_t> &waiting = readers->slots[reader_slot].waiting;
+	waiting.store(1, std::memory_order_seq_cst);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (available()) {
+		waiting.store(0, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+void EventStreamReader::disarm()
+{
+	EventStreamReaderSlot &slot = readers->slots[reader_slot];
+	if (slot.owner.load(std::memory_order_relaxed) == token) { // don't touch a slot that was taken over
+		slot.waiting.store(0, std::memory_order_relaxed);
+	}
+	uint64_t count;
+	while (read(get_fd(), &count, sizeof(count)) == sizeof(count)); // fd is nonblocking
+}
+
+bool EventStreamReader::wait(int timeout_ms)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+	while (!available()) {
+		// wake up regularly to renew the lease of the reader slot
+		int poll_ms = EVENT_STREAM_LEASE_MS/4;
+		bool last_poll = false;
+		if (timeout_ms >= 0) {
+			auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+			if (remaining.count() < 0) {
+				return false;
+			}
+			if (remaining.count() <= poll_ms) {
+				poll_ms   = remaining.count();
+				last_poll = true;
+			}
+		}
+		if (arm()) {
+			struct pollfd pfd;
+			pfd.fd = get_fd();
+			pfd.events = POLLIN;
+			// a stale notification from an earlier arm() can wake us up without new actions
+			int result = poll(&pfd, 1, poll_ms);
+			disarm();
+			if (result == 0 && last_poll) {
+				break;
+			}
+		}
+	}
+	return header->head.load(std::memory_order_acquire) != cursor;
+}
+
+int EventStreamReader::get_fd() const
+{
+	return fds[2+reader_slot];
+}
+
+uint64_t EventStreamReader::get_lost() const
+{
+	return lost;
+}
+
+bool EventStreamReader::closed() const
+{
+	return header->closed.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,151 @@
+/*  Copyright (C) 2011-2016, 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *  @author Wesley W. Terpstra <w.terpstra@gsi.de>
+ *          Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#ifndef SAFTLIB_EVENT_STREAM_HPP_
+#define SAFTLIB_EVENT_STREAM_HPP_
+
+#include "ActionRecord.hpp"
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace saftbus {
+	class Container_Proxy;
+}
+
+namespace saftlib {
+
+	struct EventStreamHeader;
+	struct EventStreamSlot;
+	struct EventStreamReaders;
+
+	/// @brief Name under which a SoftwareActionSink shares the file descriptors of its EventStream.
+	///
+	/// The first file descriptor is a read-only descriptor of the memfd with the ring, the second one 
+	/// is the memfd with the reader slots, followed by one eventfd per reader slot.
+	extern const char *event_stream_fd_name;
+
+	/// @brief Writer side of a shared memory event stream (used by SoftwareActionSink in saftbusd).
+	///
+	/// The stream is a ring of ActionRecords in a memfd that is mapped by any number of reader
+	/// processes on the same host. Each reader keeps its own cursor. The writer never waits for
+	/// readers; a reader that is too slow notices that it was overtaken and counts the lost actions.
+	/// Readers that block get one eventfd each, which is only written while that reader waits.
+	/// Readers can only map the ring read-only, and the writer never reads back from shared memory 
+	/// what it needs to write into the ring. A faulty reader can therefore not corrupt saftbusd.
+	class EventStreamWriter {
+	public:
+		/// @param capacity number of actions in the ring, rounded up to the next power of two
+		EventStreamWriter(uint32_t capacity);
+		/// @brief marks the stream as closed and wakes up all waiting readers
+		~EventStreamWriter();
+		/// @brief publish one action
+		void push(const ActionRecord &action);
+		/// @brief wake up waiting readers. Call after a number of push() calls.
+		void notify();
+		/// @brief the file descriptors for the readers, see event_stream_fd_name
+		const std::vector<int> &get_fds() const;
+		uint32_t capacity() const;
+	private:
+		EventStreamWriter(const EventStreamWriter&) = delete;
+		EventStreamWriter& operator=(const EventStreamWriter&) = delete;
+		int ring_fd; // writable, not shared
+		std::vector<int> fds;
+		EventStreamHeader *header;
+		EventStreamSlot *slots;
+		size_t mapped_size;
+		EventStreamReaders *readers;
+		uint32_t ring_capacity;
+		uint64_t ring_mask;
+		uint64_t head;
+	};
+
+	/// @brief Reader side of a shared memory event stream.
+	///
+	/// Usage in a client program:
+	///
+	///   auto stream = saftlib::EventStreamReader::create(sink_object_path);
+	///   saftlib::ActionRecord action;
+	///   while (stream->wait()) {
+	///     while (stream->pop(action)) {
+	///       ...
+	///     }
+	///   }
+	///
+	/// The EventStream of the sink has to be enabled with SoftwareActionSink::setEventStreamCapacity.
+	/// Reading actions doesn't involve saftbusd, no system call is made unless the reader waits.
+	/// Only actions that are published after the reader was created are seen.
+	///
+	/// Each reader holds one of the reader slots with a lease, which is renewed by wait() and arm().
+	/// A slot whose lease expired can be taken over by a new reader when no slot is free.
+	class EventStreamReader {
+	public:
+		/// @brief take ownership of the file descriptors that were shared by an EventStreamWriter
+		EventStreamReader(const std::vector<int> &fds);
+		~EventStreamReader();
+		/// @brief open the EventStream of a SoftwareActionSink through saftbusd
+		static std::shared_ptr<EventStreamReader> create(const std::string &sink_object_path,
+		                                                 std::shared_ptr<saftbus::Container_Proxy> container = std::shared_ptr<saftbus::Container_Proxy>());
+		/// @brief take the next action. Returns false if there is none.
+		bool pop(ActionRecord &action);
+		/// @brief take up to max actions. Returns the number of actions.
+		size_t pop(ActionRecord *actions, size_t max);
+		/// @brief block until an action is available, the timeout expires, or the stream is closed
+		/// @param timeout_ms the timeout in milliseconds, -1 blocks forever
+		/// @return true if actions are available
+		bool wait(int timeout_ms = -1);
+		/// @brief announce that the reader is about to wait on get_fd(), see ActionRing::arm()
+		///
+		/// Readers that wait on get_fd() in their own event loop have to call arm() at least every 
+		/// few seconds (e.g. with a poll timeout) to keep their slot.
+		bool arm();
+		void disarm();
+		/// @brief an eventfd that is readable after arm() when actions are available
+		///
+		/// The file descriptor changes if arm() had to claim a new reader slot after the lease expired.
+		int get_fd() const;
+		/// @brief number of actions that were overwritten before they could be read
+		uint64_t get_lost() const;
+		/// @brief true if the writer was destroyed (e.g. the stream was disabled)
+		bool closed() const;
+	private:
+		EventStreamReader(const EventStreamReader&) = delete;
+		EventStreamReader& operator=(const EventStreamReader&) = delete;
+		bool available() const;
+		void claim_slot();
+		bool renew_lease();
+		std::vector<int> fds;
+		const EventStreamHeader *header;
+		const EventStreamSlot *slots;
+		size_t mapped_size;
+		EventStreamReaders *readers;
+		unsigned reader_slot;
+		uint64_t token; // identifies this reader in the reader slot
+		int64_t lease_renewed;
+		uint64_t cursor;
+		uint64_t lost;
+	};
+
+}
+
+#endif
@@ -119,13 +119,13 @@ void FunctionGenerator::on_fg_stopped(uint64_t time, bool abort, bool hardwareUn
 
 
 bool FunctionGenerator::AppendParameterSet(
-  const std::vector< int16_t >& coeff_a,
-  const std::vector< int16_t >& coeff_b,
-  const std::vector< int32_t >& coeff_c,
-  const std::vector< unsigned char >& step,
-  const std::vector< unsigned char >& freq,
-  const std::vector< unsigned char >& shift_a,
-  const std::vector< unsigned char >& shift_b)
+  const saftbus::View< int16_t >& coeff_a,
+  const saftbus::View< int16_t >& coeff_b,
+  const saftbus::View< int32_t >& coeff_c,
+  const saftbus::View< unsigned char >& step,
+  const saftbus::View< unsigned char >& freq,
+  const saftbus::View< unsigned char >& shift_a,
+  const saftbus::View< unsigned char >& shift_b)
 {
   ownerOnly();
   return fgImpl->appendParameterSet(coeff_a, coeff_b, coeff_c, step, freq, shift_a, shift_b);  
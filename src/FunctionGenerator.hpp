@@ -151,8 +151,11 @@ class FunctionGenerator : public Owned
     /// where t ranges from 0 to numSteps-1. high_bits are the high OutputWindowSize
     /// bits of the resulting 64-bit signed value.
     /// 
+    /// The parameter vectors are read directly from the saftbus receive buffer.
+    /// A Proxy is called with std::vectors.
+    ///
     // @saftbus-export
-    bool AppendParameterSet(const std::vector< int16_t >& coeff_a, const std::vector< int16_t >& coeff_b, const std::vector< int32_t >& coeff_c, const std::vector< unsigned char >& step, const std::vector< unsigned char >& freq, const std::vector< unsigned char >& shift_a, const std::vector< unsigned char >& shift_b);
+    bool AppendParameterSet(const saftbus::View< int16_t >& coeff_a, const saftbus::View< int16_t >& coeff_b, const saftbus::View< int32_t >& coeff_c, const saftbus::View< unsigned char >& step, const saftbus::View< unsigned char >& freq, const saftbus::View< unsigned char >& shift_a, const saftbus::View< unsigned char >& shift_b);
 
     /// @brief Empty the parameter tuple set.
     ///
@@ -361,13 +361,13 @@ bool FunctionGeneratorImpl::appendParameterTuples(std::vector<ParameterTuple> pa
 
 
 bool FunctionGeneratorImpl::appendParameterSet(
-  const std::vector< int16_t >& coeff_a,
-  const std::vector< int16_t >& coeff_b,
-  const std::vector< int32_t >& coeff_c,
-  const std::vector< unsigned char >& step,
-  const std::vector< unsigned char >& freq,
-  const std::vector< unsigned char >& shift_a,
-  const std::vector< unsigned char >& shift_b )
+  const saftbus::View< int16_t >& coeff_a,
+  const saftbus::View< int16_t >& coeff_b,
+  const saftbus::View< int32_t >& coeff_c,
+  const saftbus::View< unsigned char >& step,
+  const saftbus::View< unsigned char >& freq,
+  const saftbus::View< unsigned char >& shift_a,
+  const saftbus::View< unsigned char >& shift_b )
 
 {
   // DRIVER_LOG("coeff.size()",-1, coeff_a.size());
@@ -34,6 +34,7 @@
 #include "Mailbox.hpp"
 
 #include <saftbus/loop.hpp>
+#include <saftbus/saftbus.hpp>
 
 
 namespace saftlib {
@@ -113,7 +114,7 @@ class FunctionGeneratorImpl //: public Glib::Object
     void Arm();
     void Abort();
     uint64_t ReadFillLevel();
-    bool appendParameterSet(const std::vector< int16_t >& coeff_a, const std::vector< int16_t >& coeff_b, const std::vector< int32_t >& coeff_c, const std::vector< unsigned char >& step, const std::vector< unsigned char >& freq, const std::vector< unsigned char >& shift_a, const std::vector< unsigned char >& shift_b);
+    bool appendParameterSet(const saftbus::View< int16_t >& coeff_a, const saftbus::View< int16_t >& coeff_b, const saftbus::View< int32_t >& coeff_c, const saftbus::View< unsigned char >& step, const saftbus::View< unsigned char >& freq, const saftbus::View< unsigned char >& shift_a, const saftbus::View< unsigned char >& shift_b);
     void Flush();
     uint32_t getVersion() const;
     unsigned char getSCUbusSlot() const;
@@ -42,32 +42,57 @@ void OpenDevice::check_msi_callback(eb_data_t value)
 	if (check_irq) check_irq.reset();
 	// saftd->release_irq(irq_adr);
 }
+// Polling stops draining MSIs after this time, to not block the event loop for too long.
+// If more MSIs are pending, the next poll is scheduled immediately.
+static const std::chrono::microseconds MSI_DRAIN_BUDGET(500);
+// The polling interval is doubled after this much time without MSIs ...
+static const std::chrono::milliseconds IDLE_TIME_BEFORE_BACKOFF(100);
+// ... until it reaches this multiple of the configured polling interval.
+static const int MAX_BACKOFF_FACTOR = 8;
+// Maximum number of MSI register triplets that are read speculatively in one etherbone cycle.
+static const unsigned MAX_MSI_PIPELINE_DEPTH = 16;
+
 bool OpenDevice::poll_msi(bool only_once) {
 	// std::cerr << "OpenDevice::poll_msi" << std::endl;
 	etherbone::Cycle cycle;
-	eb_data_t msi_adr = 0;
-	eb_data_t msi_dat = 0;
-	eb_data_t msi_cnt = 0;
+	eb_data_t msi_adr[MAX_MSI_PIPELINE_DEPTH];
+	eb_data_t msi_dat[MAX_MSI_PIPELINE_DEPTH];
+	eb_data_t msi_cnt[MAX_MSI_PIPELINE_DEPTH];
+	bool more_msis = false;
 	bool found_msi = false;
-	const int MAX_MSIS_IN_ONE_GO = 5; // not too many MSIs at once to not block event loop for too long 
-	for (int i = 0; i < MAX_MSIS_IN_ONE_GO; ++i) { // never more this many MSIs in one go
+	auto start = std::chrono::steady_clock::now();
+	do { // drain MSIs as long as the second bit of msi_cnt says that there are more
+		// Read msi_pipeline_depth register triplets in one cycle (i.e. one bus round trip). 
+		// Each triplet pops one MSI. If the MSI FIFO runs empty, the remaining triplets 
+		// read back with the first bit of msi_cnt cleared and are ignored.
 		cycle.open(device);
-		cycle.read_config(0x40, EB_DATA32, &msi_adr);
-		cycle.read_config(0x44, EB_DATA32, &msi_dat);
-		cycle.read_config(0x48, EB_DATA32, &msi_cnt);
+		for (unsigned i = 0; i < msi_pipeline_depth; ++i) {
+			msi_cnt[i] = 0;
+			cycle.read_config(0x40, EB_DATA32, &msi_adr[i]);
+			cycle.read_config(0x44, EB_DATA32, &msi_dat[i]);
+			cycle.read_config(0x48, EB_DATA32, &msi_cnt[i]);
+		}
 		cycle.close();
-		if (msi_cnt & 1) {
-			msi_adr = first + (msi_adr & mask);
-			needs_polling = true; // this value is 
-			found_msi = true;
-			saftd->write(msi_adr, EB_DATA32, msi_dat); // this functon is normally called by etherbone::Socket when it receives an MSI
+		unsigned n_msis = 0;
+		for (unsigned i = 0; i < msi_pipeline_depth; ++i) {
+			if (msi_cnt[i] & 1) {
+				++n_msis;
+				needs_polling = true; // this value is 
+				found_msi = true;
+				saftd->write(first + (msi_adr[i] & mask), EB_DATA32, msi_dat[i]); // this functon is normally called by etherbone::Socket when it receives an MSI
+			}
 		}
-		if (!(msi_cnt & 2)) { // no more msi to poll (second bit of msi_cnt is not set)
-			break; 
+		more_msis = msi_cnt[msi_pipeline_depth-1] & 2;
+		// adapt the number of speculative reads to the size of the last burst
+		if (more_msis) {
+			msi_pipeline_depth = std::min(2*msi_pipeline_depth, MAX_MSI_PIPELINE_DEPTH);
+		} else {
+			msi_pipeline_depth = std::max(n_msis, 1u);
 		}
-	}
-	if ((msi_cnt & 2) || found_msi) {
-		// if we polled MAX_MSIS_IN_ONE_GO but there are more MSIs (second bit of msi_cnt is set)
+	} while (more_msis && std::chrono::steady_clock::now() - start < MSI_DRAIN_BUDGET);
+
+	if (more_msis || found_msi) {
+		// if the time budget was used up but there are more MSIs (second bit of msi_cnt is set)
 		// OR if there was at least one MSI present 
 		// we have to schedule the next check immediately because the 
 		// MSI we just polled may cause actions that trigger other MSIs.
@@ -79,6 +104,13 @@ bool OpenDevice::poll_msi(bool only_once) {
 			);
 	} 
 
+	if (found_msi) {
+		idle_time = std::chrono::microseconds(0);
+		if (current_polling_interval != polling_interval) {
+			set_polling_interval(polling_interval); // tighten immediately, a burst may follow
+		}
+	}
+
 	if (only_once) {
 		// std::cerr << "polled only_once " << found_msi << std::endl;
 		// returning false removes the TimeoutSource from the event loop
@@ -88,11 +120,32 @@ bool OpenDevice::poll_msi(bool only_once) {
 		// return false if checking phase is over, and we found out that no polling is needed 
 		return false;
 	}
+	if (!found_msi && !check_msi_phase) {
+		idle_time += current_polling_interval;
+		if (idle_time >= IDLE_TIME_BEFORE_BACKOFF && current_polling_interval < max_polling_interval) {
+			idle_time = std::chrono::microseconds(0);
+			set_polling_interval(std::min(2*current_polling_interval, max_polling_interval));
+			return false; // replaced by a new TimeoutSource
+		}
+	}
 	return true;
 }
 
-OpenDevice::OpenDevice(const etherbone::Socket &socket, const std::string& eb_path, int polling_iv_ms, SAFTd *sd)
-	: etherbone_path(eb_path), eb_forward_path(eb_path), polling_interval_ms(polling_iv_ms), saftd(sd), check_msi_phase(true), needs_polling(false) 
+void OpenDevice::set_polling_interval(std::chrono::microseconds interval) {
+	saftbus::Loop::get_default().remove(poll_timeout_source);
+	current_polling_interval = interval;
+	bool only_once;
+	poll_timeout_source = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
+			std::bind(&OpenDevice::poll_msi, this, only_once=false), 
+			current_polling_interval,
+			current_polling_interval
+		);
+}
+
+OpenDevice::OpenDevice(const etherbone::Socket &socket, const std::string& eb_path, std::chrono::microseconds polling_iv, SAFTd *sd)
+	: etherbone_path(eb_path), eb_forward_path(eb_path)
+	, polling_interval(polling_iv), max_polling_interval(MAX_BACKOFF_FACTOR*polling_iv), current_polling_interval(polling_iv), idle_time(0), msi_pipeline_depth(1)
+	, saftd(sd), check_msi_phase(true), needs_polling(false) 
 {
 	std::cerr << "OpenDevice::OpenDevice(\"" << eb_path << "\")" << std::endl;
 	device.open(socket, etherbone_path.c_str());
@@ -111,12 +164,7 @@ OpenDevice::OpenDevice(const etherbone::Socket &socket, const std::string& eb_pa
 			std::cerr << "msi_target_adr for poll check: " << std::hex << std::setw(8) << std::setfill('0') << check_irq->address() << std::dec << std::endl;
 			auto slot = mbox->ConfigureSlot(check_irq->address());
 			slot->Use(MSI_TEST_VALUE); // make one single irq that should call our check_msi_callback
-			bool only_once;
-			poll_timeout_source = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
-					std::bind(&OpenDevice::poll_msi, this, only_once=false), 
-					std::chrono::milliseconds(polling_interval_ms),
-					std::chrono::milliseconds(polling_interval_ms)
-				);
+			set_polling_interval(polling_interval);
 		}
 
 		// assume that only the /dev/ttyUSB<n> devices and /dev/pts/<n> devices need eb-forwarding
@@ -32,6 +32,7 @@
 #include <saftbus/loop.hpp>
 
 #include <memory>
+#include <chrono>
 
 #include <sys/stat.h>
 
@@ -63,9 +64,9 @@ public:
 	/// @brief open given etherbone_path on given socket. 
 	/// @param socket the etherbone Socket
 	/// @param etherbone_path path of the etherbone device
-	/// @param polling_interval_ms in case of hardware without native MSIs
+	/// @param polling_interval MSI polling interval in case of hardware without native MSIs (e.g. std::chrono::microseconds(250))
 	/// @param saftd must be a valid pointer if MSIs are used
-	OpenDevice(const etherbone::Socket &socket, const std::string& etherbone_path, int polling_interval_ms = 1, SAFTd *saftd = nullptr);
+	OpenDevice(const etherbone::Socket &socket, const std::string& etherbone_path, std::chrono::microseconds polling_interval = std::chrono::milliseconds(1), SAFTd *saftd = nullptr);
 	virtual ~OpenDevice();
 
 	etherbone::Device &get_device();
@@ -93,7 +94,14 @@ private:
 
 	// polling for MSIs on hardware that doesn't support real MSIs
 	bool poll_msi(bool only_once);
-	int polling_interval_ms;
+	// Adaptive polling: the interval starts at polling_interval and is doubled (up to max_polling_interval) 
+	// whenever no MSI arrived for a while. It goes back to polling_interval as soon as an MSI arrives.
+	void set_polling_interval(std::chrono::microseconds interval);
+	std::chrono::microseconds polling_interval;         // the configured (shortest) interval
+	std::chrono::microseconds max_polling_interval;     // the longest interval when the device is idle
+	std::chrono::microseconds current_polling_interval;
+	std::chrono::microseconds idle_time;                // time since the last MSI was polled
+	unsigned msi_pipeline_depth;                        // number of MSIs that are polled in one etherbone cycle
 	saftbus::SourceHandle poll_timeout_source;
 	saftbus::SourceHandle poll_once;
 
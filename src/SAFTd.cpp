@@ -23,9 +23,11 @@
 #include <iomanip>
 #include <sstream>
 #include <cstring>
+#include <climits>
 
 #include <saftbus/error.hpp>
 #include <saftbus/loop.hpp>
+#include <saftbus/histogram.hpp>
 
 #include "eb-source.hpp"
 
@@ -42,9 +44,24 @@ extern "C" void destroy_service();
 
 namespace saftlib {
 
-	SAFTd::SAFTd(saftbus::Container *cont)
+	// time from MSI arrival in SAFTd::write until the MSI handler returned
+	static saftbus::LatencyHistogram msi_dispatch_latency("saftd-msi-dispatch");
+
+	// The thread of a device with its own etherbone::Socket. 
+	// The socket is opened, used and closed inside of the thread.
+	struct DeviceThread {
+		saftbus::LoopThread thread;
+		etherbone::Socket socket;
+		saftbus::SourceHandle eb_source;
+		saftbus::Loop &loop() { return thread.get_loop(); }
+	};
+
+	SAFTd::SAFTd(saftbus::Container *cont, bool use_device_threads)
 		: container(cont)
 		, object_path("/de/gsi/saftlib")
+		, irqs_first(0)
+		, irqs_next(0)
+		, device_threads(use_device_threads)
 	{
 		// Owned::inhibit_signals = false;
 		socket.open();
@@ -78,7 +95,20 @@ namespace saftlib {
 				// nothing
 			}
 		}
-		attached_devices.clear();
+		while (!attached_devices.empty()) {
+			RemoveObject(attached_devices.begin()->first);
+		}
+		for (;;) {
+			std::string name;
+			{
+				std::lock_guard<std::mutex> lock(threads_mutex);
+				if (threads.empty()) {
+					break;
+				}
+				name = threads.begin()->first;
+			}
+			StopDeviceThread(name);
+		}
 		saftbus::Loop::get_default().remove(eb_source);
 		try {
 			socket.close();
@@ -96,10 +126,21 @@ namespace saftlib {
 		//           <<               " " << std::hex << std::setw(8) << std::setfill('0') << data 
 		//           << std::dec 
 		//           << std::endl;
-		std::map<eb_address_t, std::function<void(eb_data_t)> >::iterator it = irqs.find(address);
-		if (it != irqs.end()) {
+		saftbus::LatencyTimer timer(msi_dispatch_latency);
+		// the slot is called without holding the lock, because it may request or release irqs
+		std::shared_ptr<std::function<void(eb_data_t)> > slot;
+		{
+			std::lock_guard<std::mutex> lock(irqs_mutex);
+			eb_address_t idx = (address-irqs_first)/4; // wraps around if address < irqs_first
+			if (idx < irqs.size() && (address&0x3) == 0) {
+				IrqEntry &entry = irqs[idx];
+				slot = entry.slot;
+				++entry.hits;
+			}
+		}
+		if (slot) {
 			try {
-				it->second(data);
+				(*slot)(data);
 			} catch (...) {
 				std::cerr << "Unhandled unknown exception in MSI handler for 0x" 
 				<< std::hex << address << std::dec << std::endl;
@@ -112,20 +153,59 @@ namespace saftlib {
 
 	std::string SAFTd::AttachDevice(const std::string& name, const std::string& etherbone_path, int polling_interval_ms) 
 	{
+		if (polling_interval_ms > INT_MAX/1000) {
+	        throw saftbus::Error(saftbus::Error::INVALID_ARGS, "polling interval too large");
+		}
+		return AttachDeviceUs(name, etherbone_path, std::max(polling_interval_ms, 1)*1000);
+	}
+
+	std::string SAFTd::AttachDeviceUs(const std::string& name, const std::string& etherbone_path, int polling_interval_us) 
+	{
+		if (polling_interval_us <= 0) {
+	        throw saftbus::Error(saftbus::Error::INVALID_ARGS, "polling interval must be positive");
+		}
 		if (attached_devices.find(name) != attached_devices.end()) {
 	        throw saftbus::Error(saftbus::Error::INVALID_ARGS, "device already exists");
 		}
 		try {
-			// create a new TimingReceiver object and add it to the attached_devices
-			TimingReceiver *timing_receiver = new TimingReceiver(*this, name, etherbone_path, polling_interval_ms, container);
-			attached_devices[name] = std::move(std::unique_ptr<TimingReceiver>(timing_receiver));
-
-			// crate a TimingReceiver_Service object
-			if (container) {
-				std::unique_ptr<TimingReceiver_Service> service (new TimingReceiver_Service(timing_receiver, std::bind(&SAFTd::RemoveObject, this, name), false));
-
-				// insert the Service object
-				container->create_object(timing_receiver->getObjectPath(), std::move(service));
+			TimingReceiver *timing_receiver = nullptr;
+			auto attach = [&]() {
+				// create a new TimingReceiver object and add it to the attached_devices
+				timing_receiver = new TimingReceiver(*this, name, etherbone_path, std::chrono::microseconds(polling_interval_us), container);
+				attached_devices[name] = std::move(std::unique_ptr<TimingReceiver>(timing_receiver));
+
+				// crate a TimingReceiver_Service object
+				if (container) {
+					std::unique_ptr<TimingReceiver_Service> service (new TimingReceiver_Service(timing_receiver, std::bind(&SAFTd::RemoveObject, this, name), false));
+
+					// insert the Service object
+					container->create_object(timing_receiver->getObjectPath(), std::move(service));
+				}
+			};
+			if (device_threads) {
+				// The TimingReceiver and all its Service objects are created inside the device thread.
+				// Therefore, all their sources are attached to the Loop of the device thread and 
+				// all their remote function calls are executed there. 
+				StopDeviceThread(name); // in case the thread of a previously removed device with the same name is still there
+				DeviceThread *device_thread = new DeviceThread;
+				{
+					// not locked during invoke_and_wait, the TimingReceiver looks up its socket in the device thread
+					std::lock_guard<std::mutex> lock(threads_mutex);
+					threads[name] = std::move(std::unique_ptr<DeviceThread>(device_thread));
+				}
+				try {
+					device_thread->loop().invoke_and_wait([&]() {
+						device_thread->socket.open();
+						device_thread->socket.attach(&eb_slave_sdb, this);
+						device_thread->eb_source = saftbus::Loop::get_default().connect<saftlib::EB_Source>(device_thread->socket);
+						attach();
+					});
+				} catch (...) {
+					StopDeviceThread(name);
+					throw;
+				}
+			} else {
+				attach();
 			}
 
 			// return the object path to the new Service object
@@ -139,6 +219,54 @@ namespace saftlib {
 		return std::string();
 	}
 
+	void SAFTd::StopDeviceThread(const std::string& name) {
+		std::unique_ptr<DeviceThread> thread;
+		{
+			std::lock_guard<std::mutex> lock(threads_mutex);
+			auto device_thread = threads.find(name);
+			if (device_thread == threads.end()) {
+				return;
+			}
+			thread = std::move(device_thread->second);
+			threads.erase(device_thread);
+		}
+		DeviceThread *t = thread.get();
+		t->loop().invoke_and_wait([t]() {
+			saftbus::Loop::get_default().remove(t->eb_source);
+			try {
+				t->socket.close();
+			} catch (etherbone::exception_t &e) {
+			}
+		});
+		thread.reset(); // stops the thread
+	}
+
+	etherbone::Socket &SAFTd::get_etherbone_socket() {
+		std::lock_guard<std::mutex> lock(threads_mutex);
+		for (auto &device_thread: threads) {
+			if (&device_thread.second->loop() == &saftbus::Loop::get_default()) {
+				return device_thread.second->socket;
+			}
+		}
+		return socket;
+	}
+
+	void SAFTd::invokeOnDevice(const std::string &name, const std::function<void()> &function) {
+		saftbus::Loop *device_loop = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(threads_mutex);
+			auto device_thread = threads.find(name);
+			if (device_thread != threads.end()) {
+				device_loop = &device_thread->second->loop();
+			}
+		}
+		if (device_loop == nullptr) {
+			function();
+		} else {
+			device_loop->invoke_and_wait(function);
+		}
+	}
+
 
 	std::string SAFTd::EbForward(const std::string& saftlib_device) {
 		auto dev = attached_devices.find(saftlib_device);
@@ -161,7 +289,28 @@ namespace saftlib {
 
 	void SAFTd::RemoveObject(const std::string& name) {
 		std::map< std::string, std::unique_ptr<TimingReceiver> >::iterator device_driver = attached_devices.find(name);
+		saftbus::Loop *device_loop_ptr = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(threads_mutex);
+			auto device_thread = threads.find(name);
+			if (device_thread != threads.end()) {
+				device_loop_ptr = &device_thread->second->loop();
+			}
+		}
+		if (device_loop_ptr == nullptr) {
+			attached_devices.erase(device_driver);
+			return;
+		}
+		// the TimingReceiver is destroyed in its device thread
+		std::unique_ptr<TimingReceiver> timing_receiver = std::move(device_driver->second);
 		attached_devices.erase(device_driver);
+		saftbus::Loop &device_loop = *device_loop_ptr;
+		device_loop.invoke_and_wait([&]() { timing_receiver.reset(); });
+		// RemoveObject is also the destruction_callback of the TimingReceiver_Service, which is called 
+		// inside the device thread. A thread cannot stop itself, it is stopped later by ~SAFTd or AttachDevice.
+		if (&saftbus::Loop::get_default() != &device_loop) {
+			StopDeviceThread(name);
+		}
 	}
 
 	void SAFTd::Quit() {
@@ -184,24 +333,42 @@ namespace saftlib {
 		return result;
 	}
 
-	bool SAFTd::request_irq(eb_address_t irq, const std::function<void(eb_data_t)>& slot) 
-	{
-		auto it = irqs.find(irq);
-		if (it == irqs.end()) {
-			// the requested address is still free
-			// std::cerr << "attach irq for address 0x" << std::hex << std::setw(8) << std::setfill('0') << irq << std::endl;
-			irqs[irq] = slot;
-			return true;
+	std::map< uint64_t, uint64_t > SAFTd::getIrqHits() const {
+		std::lock_guard<std::mutex> lock(irqs_mutex);
+		std::map< uint64_t, uint64_t > result;
+		for (size_t i = 0; i < irqs.size(); ++i) {
+			if (irqs[i].slot) {
+				result[irqs_first + 4*i] = irqs[i].hits;
+			}
+		}
+		return result;
+	}
+
+	void SAFTd::resize_irq_table(eb_address_t first, eb_address_t last) {
+		first &= ~0x3;
+		last  &= ~0x3;
+		eb_address_t irqs_last = irqs_first + 4*irqs.size() - 4;
+		if (!irqs.empty() && first >= irqs_first && last <= irqs_last) {
+			return; // already covered
+		}
+		if (!irqs.empty()) {
+			first = std::min(first, irqs_first);
+			last  = std::max(last,  irqs_last);
+		}
+		std::vector<IrqEntry> table((last-first)/4 + 1);
+		for (size_t i = 0; i < irqs.size(); ++i) {
+			table[(irqs_first-first)/4 + i] = std::move(irqs[i]);
 		}
-		// the requested address is already in use
-		return false;
+		irqs.swap(table);
+		irqs_first = first;
 	}
 	void SAFTd::release_irq(eb_address_t irq) {
-		auto it = irqs.find(irq);
-		if (it != irqs.end()) {
+		std::lock_guard<std::mutex> lock(irqs_mutex);
+		eb_address_t idx = (irq-irqs_first)/4;
+		if (idx < irqs.size() && (irq&0x3) == 0) {
 			// std::cerr << "release_irq " << std::hex << irq << std::endl;
-			// std::cerr << "release irq for address 0x" << std::hex << std::setw(8) << std::setfill('0') << irq << std::endl;
-			irqs.erase(it);
+			irqs[idx].slot.reset();
+			irqs[idx].hits = 0;
 		}
 	}
 
@@ -244,13 +411,24 @@ namespace saftlib {
 	}
 
 	std::unique_ptr<IRQ> SAFTd::request_irq(MsiDevice &msi, const std::function<void(eb_data_t)>& slot) {
-		eb_address_t first, last, mask;
+		eb_address_t first, last;
 		msi.device.enable_msi(&first, &last);
-		mask = last - first;
-		for (int i = 0; i < 2000; ++i) {
-			eb_address_t irq_adr = ((rand() & mask) + first) & (~0x3);
-			if (request_irq(irq_adr, slot)) {
+		std::lock_guard<std::mutex> lock(irqs_mutex);
+		resize_irq_table(first, last);
+		first &= ~0x3;
+		last  &= ~0x3;
+		// Search round-robin for a free address in [first,last]. Recently released 
+		// addresses are reused last, in case an MSI for them is still in flight.
+		eb_address_t n_addresses = (last-first)/4 + 1;
+		eb_address_t start = (irqs_next >= first && irqs_next <= last) ? irqs_next : first;
+		for (eb_address_t i = 0; i < n_addresses; ++i) {
+			eb_address_t irq_adr = first + ((start-first)/4 + i) % n_addresses * 4;
+			IrqEntry &entry = irqs[(irq_adr-irqs_first)/4];
+			if (!entry.slot) {
 				// std::cerr << "request_irq " << std::hex << irq_adr << std::endl;
+				entry.slot = std::make_shared<std::function<void(eb_data_t)> >(slot);
+				entry.hits = 0;
+				irqs_next = irq_adr + 4;
 				return std::unique_ptr<IRQ>(new IRQ(this, irq_adr, msi.msi_device.msi_first)); // return the adress that triggers the msi
 			}
 		}
@@ -28,6 +28,8 @@
 #include <string>
 #include <functional>
 #include <map>
+#include <vector>
+#include <mutex>
 
 #include "TimingReceiver.hpp"
 #include "eb-forward.hpp"
@@ -45,6 +47,8 @@
 /// An instance of an MsiDevice class can be used to register MSI callback functions at the SAFTd instance.
 namespace saftlib {
 
+	struct DeviceThread;
+
 	/// @brief An encapsulated etherbone::Socket with some extra features
 	///
 	/// In order to receive message passing interrupts (MSIs) from the Hardware, an instance of SAFTd driver is needed. 
@@ -59,12 +63,16 @@ namespace saftlib {
 	///    which represent wischbone masters on the MSI interconnects on the hardware.
 	///  - A container of TimingReceiver objects (std::vector<std::unique_ptr<TimingReceiver> >) and the possibility to add
 	///    an remove TimingReceiver objects at runtime.
+	///  - Optionally a separate thread for each attached device. The thread has its own etherbone::Socket and saftbus::LoopThread, 
+	///    which handle all hardware access, MSIs, MSI polling and the remote function calls of that device. A slow device cannot 
+	///    delay the MSI handling of other devices.
 	class SAFTd : public etherbone::Handler {
 		// @saftbus-default-object-path /de/gsi/saftlib
 	public:
 		/// @brief create a new SAFTd instance
 		/// @param container if not nullptr, this will be used to register Service objects whenever AttachDevice is called.
-		SAFTd(saftbus::Container *container = nullptr);
+		/// @param device_threads if true, each attached device runs in its own thread.
+		SAFTd(saftbus::Container *container = nullptr, bool device_threads = false);
 		~SAFTd();
 
 		/// @brief Instruct saftd to control a new device.
@@ -142,6 +150,27 @@ namespace saftlib {
 		// @saftbus-export
 		std::string EbForward(const std::string& saftlib_device);
 
+		/// @brief Number of MSIs that were dispatched to each of the currently requested IRQs.
+		///
+		/// @return map from IRQ address (as seen by the host) to the number of MSIs received on that address
+		///
+		// @saftbus-export
+		std::map< uint64_t, uint64_t > getIrqHits() const;
+
+		/// @brief Instruct saftd to control a new device with a sub-millisecond MSI polling interval.
+		/// @param name  The logical name for the device
+		/// @param path  The etherbone path where the device can be found
+		/// @param polling_interval_us Is the MSI polling interval in 
+		///                            microseconds which is only relevant for 
+		///                            devices that have no native MSI support
+		/// @return      Object path of the created device
+		///
+		/// Same as AttachDevice, but USB-attached devices can be polled 
+		/// faster than once per millisecond (e.g. every 100-250 us).
+		///
+		// @saftbus-export
+		std::string AttachDeviceUs(const std::string& name, const std::string& path, int polling_interval_us);
+
 		/// @brief release a callback
 		/// @param irq the address to be released
 		void release_irq(eb_address_t irq);
@@ -163,12 +192,23 @@ namespace saftlib {
 		std::string getObjectPath();
 
 		/// @brief access the underlying ehterbone::Socket
-		etherbone::Socket &get_etherbone_socket() { return socket; }
+		///
+		/// Called from the thread of an attached device, this is the etherbone::Socket of that device.
+		etherbone::Socket &get_etherbone_socket();
 
 		/// @brief access any of the managed TimingReciever driver objects
 		/// @return a pointer to the TimingReceiver, thwows if object_path was not found
 		TimingReceiver* getTimingReceiver(const std::string &object_path);
 
+		/// @brief execute a function in the thread of an attached device and wait until it is done.
+		///
+		/// Code that accesses a TimingReceiver from outside (e.g. plugins that install addons) has to 
+		/// use this function, because the device may run in its own thread.
+		/// If the device has no own thread, the function is executed immediately.
+		/// @param name the logical name of the device
+		/// @param function is called in the thread of the device
+		void invokeOnDevice(const std::string &name, const std::function<void()> &function);
+
 		/// @brief Implementation of the virtual function etherbone::Handler::read
 		///
 		/// read/write virtual functions from etherbone::Handler base class are used
@@ -181,16 +221,14 @@ namespace saftlib {
 	private:
 
 
-		/// @brief try to attach a callback to an irq address
-		///
-		/// @param irq the address at which the callback should be attached
-		/// @param slot the function object
-		/// @return true if the requested address was still free, false if the 
-		///         requested address was already in use
-		bool request_irq(eb_address_t irq, const std::function<void(eb_data_t)>& slot);
+		/// @brief make sure that the IRQ table covers the address range [first,last]
+		void resize_irq_table(eb_address_t first, eb_address_t last);
 
 		void RemoveObject(const std::string& name);
 
+		// stop the thread of a device after the TimingReceiver was removed
+		void StopDeviceThread(const std::string& name);
+
 		// The sdb structure for this "virtual" etherbone device
 		sdb_device eb_slave_sdb;
 
@@ -209,7 +247,21 @@ namespace saftlib {
 		// remember all attached devices 
 		std::map<std::string, std::unique_ptr<TimingReceiver> > attached_devices;
 
-		std::map<eb_address_t, std::function<void(eb_data_t)> > irqs;
+		// IRQ table, indexed by (address-irqs_first)/4. An entry is free if its slot is empty.
+		// The slot is a shared_ptr so that it can be copied cheaply under the lock and called without it.
+		struct IrqEntry {
+			std::shared_ptr<std::function<void(eb_data_t)> > slot;
+			uint64_t hits;
+		};
+		std::vector<IrqEntry> irqs;
+		eb_address_t irqs_first;
+		eb_address_t irqs_next;        // free slots are searched round-robin starting at this address
+		mutable std::mutex irqs_mutex; // irqs are requested and dispatched in the device threads
+
+		// if true, each device gets its own etherbone::Socket and saftbus::LoopThread
+		bool device_threads;
+		std::map<std::string, std::unique_ptr<DeviceThread> > threads;
+		mutable std::mutex threads_mutex; // threads are changed in the main thread and looked up in the device threads
 
 		bool quit;
 
@@ -0,0 +1,42 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH 
+ *
+ *  @author Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#include "SaftbusBench.hpp"
+
+#include <chrono>
+
+namespace saftlib {
+
+	std::vector<uint8_t> SaftbusBench::Echo(const std::vector<uint8_t> &payload) {
+		return payload;
+	}
+
+	void SaftbusBench::Emit(uint32_t count, uint32_t size) {
+		if (!SigData) {
+			return;
+		}
+		std::vector<uint8_t> payload(size);
+		for (uint32_t i = 0; i < count; ++i) {
+			int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			SigData(i, now, payload);
+		}
+	}
+
+}
@@ -0,0 +1,56 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH 
+ *
+ *  @author Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#ifndef SAFTBUS_BENCH_HPP_
+#define SAFTBUS_BENCH_HPP_
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+namespace saftlib {
+
+	/// @brief Service for saftbus benchmarks, independent of timing hardware.
+	///
+	/// It is loaded as plugin libsaftbus-bench-service.so into saftbusd and used by saftbus-bench 
+	/// to measure remote calls per second, signal fan-out rate, and latencies.
+	class SaftbusBench {
+	public:
+		/// @brief return the payload to the caller
+		/// @param payload arbitrary data, the size is chosen by the benchmark
+		/// @return the same data
+		///
+		// @saftbus-export
+		std::vector<uint8_t> Echo(const std::vector<uint8_t> &payload);
+
+		/// @brief emit count SigData signals with a payload of size bytes
+		///
+		// @saftbus-export
+		void Emit(uint32_t count, uint32_t size);
+
+		/// @brief signal with sequence number, steady_clock time of emission (in ns), and payload
+		///
+		// @saftbus-export
+		std::function<void(uint32_t seq, int64_t time_ns, std::vector<uint8_t> payload)> SigData;
+	};
+
+}
+
+#endif
@@ -21,6 +21,7 @@
 
 #include "SoftwareActionSink.hpp"
 #include "ECA.hpp"
+#include "eca_regs.h"
 #include "eca_queue_regs.h"
 #include "eca_flags.h"
 
@@ -28,13 +29,20 @@
 #include "SoftwareCondition.hpp"
 #include "SoftwareCondition_Service.hpp"
 
+#include <saftbus/error.hpp>
+#include <saftbus/histogram.hpp>
+
 
 #include <cassert>
 #include <sstream>
 #include <memory>
+#include <algorithm>
 
 namespace saftlib {
 
+// time needed to read the actions from the ECA queue in receiveMSI
+static saftbus::LatencyHistogram queue_read_latency("softwareactionsink-queue-read");
+
 SoftwareActionSink::SoftwareActionSink(ECA &eca
 			                         , const std::string &obj_path
                                      , const std::string &name
@@ -44,12 +52,98 @@ SoftwareActionSink::SoftwareActionSink(ECA &eca
 {
 }
 
+SoftwareActionSink::~SoftwareActionSink()
+{
+	if (event_stream) {
+		container->set_shared_fds(getObjectPath(), event_stream_fd_name, std::vector<int>());
+	}
+}
+
 
 // SoftwareActionSink::SoftwareActionSink(const std::string &object_path, TimingReceiver *dev, const std::string &name, unsigned channel, unsigned num, eb_address_t queue, saftbus::Container *container)
 //  : ActionSink(object_path, dev, name, channel, num, container), queue(queue)
 // {
 // }
 
+void SoftwareActionSink::readQueueRecord(etherbone::Cycle &cycle, QueueRecord &record)
+{
+	cycle.read(queue + ECA_QUEUE_FLAGS_GET,       EB_DATA32, &record.flags);
+	cycle.read(queue + ECA_QUEUE_NUM_GET,         EB_DATA32, &record.rawNum);
+	cycle.read(queue + ECA_QUEUE_EVENT_ID_HI_GET, EB_DATA32, &record.event_hi);
+	cycle.read(queue + ECA_QUEUE_EVENT_ID_LO_GET, EB_DATA32, &record.event_lo);
+	cycle.read(queue + ECA_QUEUE_PARAM_HI_GET,    EB_DATA32, &record.param_hi);
+	cycle.read(queue + ECA_QUEUE_PARAM_LO_GET,    EB_DATA32, &record.param_lo);
+	cycle.read(queue + ECA_QUEUE_TAG_GET,         EB_DATA32, &record.tag);
+	cycle.read(queue + ECA_QUEUE_TEF_GET,         EB_DATA32, &record.tef);
+	cycle.read(queue + ECA_QUEUE_DEADLINE_HI_GET, EB_DATA32, &record.deadline_hi);
+	cycle.read(queue + ECA_QUEUE_DEADLINE_LO_GET, EB_DATA32, &record.deadline_lo);
+	cycle.read(queue + ECA_QUEUE_EXECUTED_HI_GET, EB_DATA32, &record.executed_hi);
+	cycle.read(queue + ECA_QUEUE_EXECUTED_LO_GET, EB_DATA32, &record.executed_lo);
+	cycle.write(queue + ECA_QUEUE_POP_OWR, EB_DATA32, 1);
+}
+
+bool SoftwareActionSink::dispatchQueueRecord(const QueueRecord &record)
+{
+	uint64_t id       = uint64_t(record.event_hi)    << 32 | record.event_lo;
+	uint64_t param    = uint64_t(record.param_hi)    << 32 | record.param_lo;
+	uint64_t deadline = uint64_t(record.deadline_hi) << 32 | record.deadline_lo;
+	uint64_t executed = uint64_t(record.executed_hi) << 32 | record.executed_lo;
+	
+	if ((record.flags & (1<<ECA_VALID)) == 0) {
+		std::cerr << "SoftwareActionSink: MSI for increase in VALID_COUNT did not correspond to a valid action in the queue" << std::endl;
+		return false;
+	}
+	
+	if (record.rawNum != num) {
+		std::cerr << "SoftwareActionSink: MSI dispatched to wrong queue" << std::endl;
+		return false;
+	}
+	
+	Conditions::iterator it = conditions.find(record.tag);
+	if (it == conditions.end()) {
+		// This can happen if the user deletes a condition at the same time a match arrives
+		// => Just silently discard the action on this race condition
+		return true;
+	} 
+
+	if (event_stream || action_ring) {
+		ActionRecord action{};
+		action.event    = id;
+		action.param    = param;
+		action.deadline = saftlib::makeTimeTAI(deadline);
+		action.executed = saftlib::makeTimeTAI(executed);
+		action.flags    = record.flags & 0xF;
+		if (event_stream) {
+			event_stream->push(action);
+		}
+		// Standalone clients take the actions directly from the ring
+		if (action_ring) {
+			action_ring->push(action);
+			return true;
+		}
+	}
+
+	// Emit the Action
+	if (!it->second) {
+		std::cerr << "SoftwareActionSink: a Condition was not a SoftwareCondition" << std::endl;
+		return true;
+	}
+	
+	// DRIVER_LOG("deadline",-1, deadline);
+	// DRIVER_LOG("id",      -1, id);
+	// Inform clients
+	// softwareCondition->Action(id, param, deadline, executed, flags & 0xF);
+	// std::cerr << "cast" << std::endl;
+	Condition* cond = it->second.get();
+	SoftwareCondition* sw_cond = dynamic_cast<SoftwareCondition*>(cond);
+	// std::cerr << "SigAction" << std::endl;
+	sw_cond->deliver(id, param, saftlib::makeTimeTAI(deadline), saftlib::makeTimeTAI(executed), record.flags & 0xF);
+	if (sw_cond->getBatchActions() && std::find(batched.begin(), batched.end(), sw_cond) == batched.end()) {
+		batched.push_back(sw_cond);
+	}
+	return true;
+}
+
 void SoftwareActionSink::receiveMSI(uint8_t code)
 {
 	// std::cerr << "SoftwareActionSink::receiveMSI " << (int)code << std::endl;
@@ -57,67 +151,66 @@ void SoftwareActionSink::receiveMSI(uint8_t code)
 	if (code == ECA_VALID) {
 		// std::cerr << "ECA_VALID" << std::endl;
 		// DRIVER_LOG("MSI-ECA_VALID",-1, code);
-		updateAction(); // increase the counter, rearming the MSI
-		
-		eb_data_t flags, rawNum, event_hi, event_lo, param_hi, param_lo, 
-							tag, tef, deadline_hi, deadline_lo, executed_hi, executed_lo;
-		
-		// std::cerr << "read data" << std::endl;
+		eb_data_t valid;
+
+		// The first cycle does what updateAction() does (increase the counter, rearming the MSI)
+		// and pops the first action from the queue. 
+		// The read data must not be moved while a cycle is open => no resize of records until it is closed.
+		saftbus::LatencyTimer timer(queue_read_latency);
+		records.resize(1);
 		etherbone::Cycle cycle;
 		cycle.open(eca.get_device());
-		cycle.read(queue + ECA_QUEUE_FLAGS_GET,       EB_DATA32, &flags);
-		cycle.read(queue + ECA_QUEUE_NUM_GET,         EB_DATA32, &rawNum);
-		cycle.read(queue + ECA_QUEUE_EVENT_ID_HI_GET, EB_DATA32, &event_hi);
-		cycle.read(queue + ECA_QUEUE_EVENT_ID_LO_GET, EB_DATA32, &event_lo);
-		cycle.read(queue + ECA_QUEUE_PARAM_HI_GET,    EB_DATA32, &param_hi);
-		cycle.read(queue + ECA_QUEUE_PARAM_LO_GET,    EB_DATA32, &param_lo);
-		cycle.read(queue + ECA_QUEUE_TAG_GET,         EB_DATA32, &tag);
-		cycle.read(queue + ECA_QUEUE_TEF_GET,         EB_DATA32, &tef);
-		cycle.read(queue + ECA_QUEUE_DEADLINE_HI_GET, EB_DATA32, &deadline_hi);
-		cycle.read(queue + ECA_QUEUE_DEADLINE_LO_GET, EB_DATA32, &deadline_lo);
-		cycle.read(queue + ECA_QUEUE_EXECUTED_HI_GET, EB_DATA32, &executed_hi);
-		cycle.read(queue + ECA_QUEUE_EXECUTED_LO_GET, EB_DATA32, &executed_lo);
-		cycle.write(queue + ECA_QUEUE_POP_OWR, EB_DATA32, 1);
+		cycle.write(eca.get_base_address() + ECA_CHANNEL_SELECT_RW,       EB_DATA32, channel);
+		cycle.write(eca.get_base_address() + ECA_CHANNEL_NUM_SELECT_RW,   EB_DATA32, num);
+		// reading VALID_COUNT clears the count and rearms the MSI
+		cycle.read (eca.get_base_address() + ECA_CHANNEL_VALID_COUNT_GET, EB_DATA32, &valid);
+		readQueueRecord(cycle, records[0]);
 		cycle.close();
-		// std::cerr << "read done" << std::endl;
-		
-		uint64_t id       = uint64_t(event_hi)    << 32 | event_lo;
-		uint64_t param    = uint64_t(param_hi)    << 32 | param_lo;
-		uint64_t deadline = uint64_t(deadline_hi) << 32 | deadline_lo;
-		uint64_t executed = uint64_t(executed_hi) << 32 | executed_lo;
-		
-		if ((flags & (1<<ECA_VALID)) == 0) {
-			std::cerr << "SoftwareActionSink: MSI for increase in VALID_COUNT did not correspond to a valid action in the queue" << std::endl;
-			return;
+
+		// VALID_COUNT tells how many actions arrived since the last read.
+		// All but the first of them are still in the queue. Drain them with
+		// up to MAX_POPS_IN_ONE_CYCLE pops per etherbone cycle. Each action 
+		// that is popped here will not need an MSI roundtrip of its own; the
+		// MSIs that might still arrive for them will see VALID_COUNT=0.
+		// A corrupt VALID_COUNT must not make us pop more actions than the queue can hold.
+		if (valid > 1) {
+			records.resize(std::min<eb_data_t>(valid, capacity));
+			for (unsigned first = 1; first < records.size(); first += MAX_POPS_IN_ONE_CYCLE) {
+				unsigned last = std::min<unsigned>(first + MAX_POPS_IN_ONE_CYCLE, records.size());
+				cycle.open(eca.get_device());
+				for (unsigned i = first; i < last; ++i) {
+					readQueueRecord(cycle, records[i]);
+				}
+				cycle.close();
+			}
 		}
-		
-		if (rawNum != num) {
-			std::cerr << "SoftwareActionSink: MSI dispatched to wrong queue" << std::endl;
+		timer.stop();
+
+		actionCount += valid;
+		ActionCount(actionCount);
+		actionUpdate = std::chrono::steady_clock::now();
+
+		if (valid == 0 && (records[0].flags & (1<<ECA_VALID)) == 0) {
+			// The action for this MSI was already drained by an earlier batch
 			return;
 		}
-		
-		// Emit the Action
-		Conditions::iterator it = conditions.find(tag);
-		if (it == conditions.end()) {
-			// This can happen if the user deletes a condition at the same time a match arrives
-			// => Just silently discard the action on this race condition
-			return;
-		} 
-		
-		if (!it->second) {
-			std::cerr << "SoftwareActionSink: a Condition was not a SoftwareCondition" << std::endl;
-			return;
+
+		// Emit the Actions after all hardware access is done.
+		// Invalid records are reported and skipped, they must not hide the valid ones behind them.
+		for (auto &record: records) {
+			dispatchQueueRecord(record);
 		}
-		
-		// DRIVER_LOG("deadline",-1, deadline);
-		// DRIVER_LOG("id",      -1, id);
-		// Inform clients
-		// softwareCondition->Action(id, param, deadline, executed, flags & 0xF);
-		// std::cerr << "cast" << std::endl;
-		Condition* cond = it->second.get();
-		SoftwareCondition* sw_cond = dynamic_cast<SoftwareCondition*>(cond);
-		// std::cerr << "SigAction" << std::endl;
-		sw_cond->SigAction(id, param, saftlib::makeTimeTAI(deadline), saftlib::makeTimeTAI(executed), flags & 0xF);
+		if (action_ring) {
+			action_ring->notify();
+		}
+		if (event_stream) {
+			event_stream->notify();
+		}
+		// Batches without a window end with the queue drain
+		for (auto sw_cond: batched) {
+			sw_cond->drained();
+		}
+		batched.clear();
 		
 	} else {
 		// std::cerr << "not ECA_VALID" << std::endl;
@@ -127,6 +220,30 @@ void SoftwareActionSink::receiveMSI(uint8_t code)
 	}
 }
 
+uint32_t SoftwareActionSink::getEventStreamCapacity() const {
+	return event_stream ? event_stream->capacity() : 0;
+}
+
+void SoftwareActionSink::setEventStreamCapacity(uint32_t capacity) {
+	ownerOnly();
+	if (!container) {
+		throw saftbus::Error(saftbus::Error::INVALID_ARGS, "an EventStream can only be used with saftbus");
+	}
+	if (event_stream) {
+		// unregister the file descriptors before the writer closes them
+		container->set_shared_fds(getObjectPath(), event_stream_fd_name, std::vector<int>());
+		event_stream.reset();
+	}
+	if (capacity) {
+		event_stream.reset(new EventStreamWriter(capacity));
+		container->set_shared_fds(getObjectPath(), event_stream_fd_name, event_stream->get_fds());
+	}
+}
+
+void SoftwareActionSink::setActionRing(std::shared_ptr<ActionRing> ring) {
+	action_ring = ring;
+}
+
 SoftwareCondition * SoftwareActionSink::getCondition(const std::string object_path) {
 	return dynamic_cast<SoftwareCondition*>(ActionSink::getCondition(object_path));
 }
@@ -138,4 +255,15 @@ std::string SoftwareActionSink::NewCondition(bool active, uint64_t id, uint64_t
 	return NewConditionHelper<SoftwareCondition>(active, id, mask, offset, container);
 }
 
+std::vector< std::string > SoftwareActionSink::NewConditions(bool active, const std::vector< uint64_t > &ids, const std::vector< uint64_t > &masks, const std::vector< int64_t > &offsets, const std::vector< uint8_t > &accept_flags)
+{
+	ownerOnly();
+	if (ids.size() != masks.size() || ids.size() != offsets.size()) {
+		throw saftbus::Error(saftbus::Error::INVALID_ARGS, "ids, masks, and offsets must have the same size");
+	}
+	return NewConditionsHelper(active, ids.size(), accept_flags, [&](unsigned i) -> Condition* {
+		return InsertConditionHelper<SoftwareCondition>(false, ids[i], masks[i], offsets[i], container);
+	});
+}
+
 }
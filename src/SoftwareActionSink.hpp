@@ -30,6 +30,11 @@
 #include <etherbone.h>
 
 #include "ActionSink.hpp"
+#include "ActionRing.hpp"
+#include "EventStream.hpp"
+
+#include <vector>
+#include <memory>
 
 namespace saftlib {
 
@@ -56,6 +61,7 @@ namespace saftlib {
 			             , const std::string &name
 			             , unsigned channel, unsigned num, eb_address_t queue_address
 			             , saftbus::Container *container = nullptr);
+		~SoftwareActionSink();
 
 		/// NewCondition: Create a condition to match incoming events
 		///
@@ -74,13 +80,78 @@ namespace saftlib {
 		// @saftbus-export
 		std::string NewCondition(bool active, uint64_t id, uint64_t mask, int64_t offset);
 
+		/// NewConditions: Create many conditions at once
+		///
+		///   @param active       Should the conditions be immediately active
+		///   @param ids          Event IDs to match incoming event IDs against
+		///   @param masks        Set of bits for which the event ID and id must agree
+		///   @param offsets      Delay in nanoseconds between event and action
+		///   @param accept_flags Bitmask of (1<<ECA_LATE), (1<<ECA_EARLY), (1<<ECA_CONFLICT), 
+		///                       (1<<ECA_DELAYED) for each condition. If empty, the 
+		///                       defaults of NewCondition are used.
+		///   @return             Object paths to the created SoftwareConditions
+		///
+		/// Equivalent to calling NewCondition and setAccept* for each entry of 
+		/// ids, masks, and offsets, but the hardware tables are compiled only once.
+		/// Either all conditions are created or (in case of an error) none.
+		///
+		// @saftbus-export
+		std::vector< std::string > NewConditions(bool active, const std::vector< uint64_t > &ids, const std::vector< uint64_t > &masks, const std::vector< int64_t > &offsets, const std::vector< uint8_t > &accept_flags);
+
+		/// @brief Publish all actions of this sink in a shared memory ring for local clients.
+		/// @return The capacity of the ring (number of actions), 0 if the stream is disabled (default).
+		///
+		/// Clients on the same host read the stream with saftlib::EventStreamReader::create(object_path)
+		/// without any further communication with saftbusd. All actions of the sink are published,
+		/// regardless of the filter, decimation, aggregation, and batching settings of its conditions.
+		/// SoftwareCondition signals are still emitted. Readers that don't keep up lose the
+		/// oldest actions. Changing the capacity closes the stream for all current readers.
+		///
+		// @saftbus-export
+		uint32_t getEventStreamCapacity() const;
+		// @saftbus-export
+		void setEventStreamCapacity(uint32_t capacity);
+
 		// override receiveMSI to also pop the software queue
 		void receiveMSI(uint8_t code);
 
 		SoftwareCondition * getCondition(const std::string object_path);
+
+		/// @brief Deliver all actions of this sink into ring instead of emitting signals (standalone use only).
+		///
+		/// The actions of all conditions on this sink are pushed into the ring, right after
+		/// they were read from the hardware. SoftwareCondition signals are not emitted and
+		/// their filter, decimation, aggregation, and batching settings have no effect.
+		/// Actions of deleted conditions are discarded. The ring entries don't tell which condition
+		/// matched; a consumer with several conditions has to tell them apart by the event ID.
+		/// A nullptr restores signal delivery. Call this before the thread that
+		/// consumes the ring is started.
+		void setActionRing(std::shared_ptr<ActionRing> ring);
 		
 	protected:
 		eb_address_t queue;
+
+	private:
+		// one entry of the software queue as it is read from hardware
+		struct QueueRecord {
+			eb_data_t flags, rawNum, event_hi, event_lo, param_hi, param_lo, 
+			          tag, tef, deadline_hi, deadline_lo, executed_hi, executed_lo;
+		};
+		// add reads of one queue entry and its pop to an open cycle
+		void readQueueRecord(etherbone::Cycle &cycle, QueueRecord &record);
+		// emit SigAction for one queue entry (or complain about it). Returns false on a hardware inconsistency.
+		bool dispatchQueueRecord(const QueueRecord &record);
+
+		// maximum number of queue entries that are popped in one etherbone cycle
+		static const unsigned MAX_POPS_IN_ONE_CYCLE = 16;
+		// reused buffer for the queue entries of one MSI
+		std::vector<QueueRecord> records;
+		// conditions that received actions for batched delivery during the current drain
+		std::vector<SoftwareCondition*> batched;
+		// if set, actions go here instead of SoftwareCondition::deliver
+		std::shared_ptr<ActionRing> action_ring;
+		// shared memory stream for local clients (nullptr if disabled)
+		std::unique_ptr<EventStreamWriter> event_stream;
 	};
 
 }
@@ -30,8 +30,152 @@ namespace saftlib {
 
 SoftwareCondition::SoftwareCondition(ActionSink *sink, unsigned number, bool active, uint64_t id, uint64_t mask, int64_t offset, saftbus::Container *container = nullptr)
  : Condition(sink, number, active, id, mask, offset, number, container)
+ , decimation(1), decimation_count(0)
+ , param_filter_value(0), param_filter_mask(0)
+ , aggregation_interval_ms(0)
+ , aggregated_count(0), aggregated_id(0), aggregated_param(0), aggregated_flags(0)
+ , batch_actions(false), batch_window_us(0)
 {
   // std::cerr << "SoftwareCondition::SoftwareCondition()" << std::endl;
 }
 
+SoftwareCondition::~SoftwareCondition()
+{
+  saftbus::Loop::get_default().remove(aggregation_timeout);
+  saftbus::Loop::get_default().remove(batch_timeout);
+}
+
+uint32_t SoftwareCondition::getDecimation() const
+{
+  return decimation;
+}
+
+void SoftwareCondition::setDecimation(uint32_t n)
+{
+  decimation = n ? n : 1;
+  decimation_count = 0;
+}
+
+void SoftwareCondition::setParamFilter(uint64_t value, uint64_t mask)
+{
+  param_filter_value = value & mask;
+  param_filter_mask  = mask;
+}
+
+uint64_t SoftwareCondition::getParamFilterValue() const
+{
+  return param_filter_value;
+}
+
+uint64_t SoftwareCondition::getParamFilterMask() const
+{
+  return param_filter_mask;
+}
+
+uint32_t SoftwareCondition::getAggregationInterval() const
+{
+  return aggregation_interval_ms;
+}
+
+void SoftwareCondition::setAggregationInterval(uint32_t interval_ms)
+{
+  if (interval_ms == aggregation_interval_ms) return;
+  saftbus::Loop::get_default().remove(aggregation_timeout);
+  emit_aggregation(); // don't lose the actions of the current interval
+  aggregation_interval_ms = interval_ms;
+  if (aggregation_interval_ms) {
+    aggregation_timeout = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
+        std::bind(&SoftwareCondition::emit_aggregation, this), 
+        std::chrono::milliseconds(aggregation_interval_ms), 
+        std::chrono::milliseconds(aggregation_interval_ms)
+      );
+  }
+}
+
+bool SoftwareCondition::emit_aggregation()
+{
+  if (aggregated_count) {
+    SigActionCount(aggregated_count, aggregated_id, aggregated_param, aggregated_executed, aggregated_flags);
+    aggregated_count = 0;
+    aggregated_flags = 0;
+  }
+  return true;
+}
+
+bool SoftwareCondition::getBatchActions() const
+{
+  return batch_actions;
+}
+
+void SoftwareCondition::setBatchActions(bool batch_)
+{
+  if (!batch_) emit_batch();
+  batch_actions = batch_;
+}
+
+uint32_t SoftwareCondition::getBatchWindow() const
+{
+  return batch_window_us;
+}
+
+void SoftwareCondition::setBatchWindow(uint32_t window_us)
+{
+  emit_batch();
+  batch_window_us = window_us;
+}
+
+bool SoftwareCondition::emit_batch()
+{
+  saftbus::Loop::get_default().remove(batch_timeout);
+  batch_timeout = saftbus::SourceHandle();
+  if (!batch.empty()) {
+    SigActions(batch);
+    batch.clear();
+  }
+  return false; // one-shot timeout
+}
+
+void SoftwareCondition::drained()
+{
+  if (!batch_window_us) emit_batch();
+}
+
+void SoftwareCondition::deliver(uint64_t id, uint64_t param, const saftlib::Time &deadline, const saftlib::Time &executed, uint16_t flags)
+{
+  // filtered actions are dropped before anything is serialized
+  if ((param & param_filter_mask) != param_filter_value) return;
+  if (decimation > 1) {
+    if (++decimation_count < decimation) return;
+    decimation_count = 0;
+  }
+  if (aggregation_interval_ms) {
+    ++aggregated_count;
+    aggregated_id       = id;
+    aggregated_param    = param;
+    aggregated_executed = executed;
+    aggregated_flags   |= flags;
+    return;
+  }
+  if (batch_actions) {
+    ActionRecord record{};
+    record.event    = id;
+    record.param    = param;
+    record.deadline = deadline;
+    record.executed = executed;
+    record.flags    = flags;
+    batch.push_back(record);
+    if (batch.size() >= MAX_BATCH_SIZE) {
+      emit_batch();
+    } else if (batch_window_us && !batch_timeout.connected()) {
+      batch_timeout = saftbus::Loop::get_default().connect<saftbus::TimeoutSource>(
+          std::bind(&SoftwareCondition::emit_batch, this), 
+          std::chrono::microseconds(batch_window_us), 
+          std::chrono::microseconds(batch_window_us)
+        );
+    }
+    return;
+  }
+  SigAction(id, param, deadline, executed, flags);
+}
+
 }
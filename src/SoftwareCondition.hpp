@@ -29,9 +29,12 @@
 // @saftbus-include
 #include <Time.hpp>
 // @saftbus-include
+#include <ActionRecord.hpp>
+// @saftbus-include
 #include <sigc++/sigc++.h>
 
 #include <saftbus/service.hpp>
+#include <saftbus/loop.hpp>
 
 
 #include <functional>
@@ -50,6 +53,7 @@ class SoftwareCondition : public Condition
 {
 public:
 	SoftwareCondition(ActionSink *sink, unsigned number, bool active, uint64_t id, uint64_t mask, int64_t offset, saftbus::Container *container);
+	~SoftwareCondition();
 
 	/// @brief    Emitted whenever the condition matches a timing event.
 	/// 
@@ -75,7 +79,114 @@ public:
 	// // @saftbus-export
 	// std::function< void(uint64_t event, uint64_t param, saftlib::Time deadline, saftlib::Time executed, uint16_t flags) > Action;
 
+	/// @brief Only every n-th matching action is delivered.
+	/// @return The decimation factor. Defaults to 1, i.e. all actions are delivered.
+	///
+	/// Actions that are not delivered are dropped in saftbusd, they don't cause any 
+	/// signal traffic. Decimation is applied after the parameter filter.
+	///
+	// @saftbus-export
+	uint32_t getDecimation() const;
+	// @saftbus-export
+	void setDecimation(uint32_t n);
+
+	/// @brief Only actions with (param & mask) == (value & mask) are delivered.
+	///
+	/// @param value the required parameter bits
+	/// @param mask  the parameter bits that are compared. Defaults to 0, i.e. all actions are delivered.
+	///
+	// @saftbus-export
+	void setParamFilter(uint64_t value, uint64_t mask);
+	// @saftbus-export
+	uint64_t getParamFilterValue() const;
+	// @saftbus-export
+	uint64_t getParamFilterMask() const;
+
+	/// @brief Deliver the number of actions every interval_ms milliseconds instead of each action.
+	/// @return The aggregation interval in milliseconds. Defaults to 0, i.e. each action is delivered with SigAction.
+	///
+	/// If the interval is not 0, SigAction is not emitted. Instead, SigActionCount reports 
+	/// the number of actions (after filter and decimation) that matched during the last interval. 
+	/// Nothing is emitted for intervals without actions.
+	///
+	// @saftbus-export
+	uint32_t getAggregationInterval() const;
+	// @saftbus-export
+	void setAggregationInterval(uint32_t interval_ms);
+
+	/// @brief Emitted every aggregation interval if actions matched during that interval (see AggregationInterval).
+	///
+	/// @param count         The number of actions that matched during the interval.
+	/// @param last_event    The event identifier of the last action.
+	/// @param last_param    The parameter of the last action.
+	/// @param last_executed The execution timestamp of the last action.
+	/// @param flags         All flags of the actions or'ed together (late=1,early=2,conflict=4,delayed=8).
+	///
+	// @saftbus-export
+	sigc::signal<void, uint64_t, uint64_t, uint64_t, saftlib::Time, uint16_t > SigActionCount;
+
+	/// @brief Deliver actions in batches with SigActions instead of one SigAction per action.
+	/// @return true if batched delivery is enabled. Defaults to false.
+	///
+	/// A batch contains all actions that were taken from the hardware queue 
+	/// together, or that matched during the BatchWindow. Batching is applied after
+	/// filter and decimation. Aggregation takes precedence over batching.
+	///
+	// @saftbus-export
+	bool getBatchActions() const;
+	// @saftbus-export
+	void setBatchActions(bool batch);
+
+	/// @brief Maximum time that actions are held back to be delivered in one batch.
+	/// @return The batch window in microseconds. Defaults to 0.
+	///
+	/// With a window of 0, each batch contains the actions that were read from the 
+	/// hardware queue in one go. Otherwise, a batch is delivered at most window_us 
+	/// microseconds after its first action matched. 
+	///
+	// @saftbus-export
+	uint32_t getBatchWindow() const;
+	// @saftbus-export
+	void setBatchWindow(uint32_t window_us);
+
+	/// @brief Emitted with all actions of one batch if BatchActions is enabled.
+	///
+	/// @param actions The actions in the order they were executed. Each entry 
+	///                has the same content as the arguments of SigAction.
+	///
+	/// Use saftlib::for_each_action to connect handlers written for SigAction.
+	///
+	// @saftbus-export
+	sigc::signal<void, std::vector< saftlib::ActionRecord > > SigActions;
+
+	/// @brief called by SoftwareActionSink for each matching action. Applies filter, decimation, aggregation, and batching.
+	void deliver(uint64_t id, uint64_t param, const saftlib::Time &deadline, const saftlib::Time &executed, uint16_t flags);
+	/// @brief called by SoftwareActionSink after all actions from the hardware queue were delivered.
+	void drained();
+
 	typedef SoftwareCondition_Service ServiceType;
+private:
+	bool emit_aggregation();
+	bool emit_batch();
+
+	// batches are delivered early when they reach this size
+	static const size_t MAX_BATCH_SIZE = 4096;
+
+	uint32_t decimation;
+	uint32_t decimation_count;
+	uint64_t param_filter_value;
+	uint64_t param_filter_mask;
+	uint32_t aggregation_interval_ms;
+	saftbus::SourceHandle aggregation_timeout;
+	uint64_t aggregated_count;
+	uint64_t aggregated_id;
+	uint64_t aggregated_param;
+	saftlib::Time aggregated_executed;
+	uint16_t aggregated_flags;
+	bool batch_actions;
+	uint32_t batch_window_us;
+	saftbus::SourceHandle batch_timeout;
+	std::vector<saftlib::ActionRecord> batch;
 };
 
 }
@@ -110,7 +110,7 @@ class TimingReceiver : public OpenDevice
                      , public LM32Cluster {
 public:
 	TimingReceiver(SAFTd &saftd, const std::string &name, const std::string &etherbone_path, 
-		           int polling_interval_ms = 1, saftbus::Container *container = nullptr);
+		           std::chrono::microseconds polling_interval = std::chrono::milliseconds(1), saftbus::Container *container = nullptr);
 	~TimingReceiver();
 
 	const std::string &getObjectPath() const;
@@ -27,6 +27,7 @@
 #include <map>
 #include <string>
 #include <sstream>
+#include <algorithm>
 
 #include <saftbus/error.hpp>
 
@@ -47,8 +48,8 @@ void destroy_service() {
 /// @param saftd a pointer to a SAFTd
 /// @param name logical saftlib name. For example tr0, tr1 or tr*
 /// @param etherbone_path etherbone path. If name has a '*' as last character, etherbone_path needs '*' as last character, too.
-/// @param poll_interval_ms this is directly passed to AttachDevice function
-void handle_wildcards_and_attach_device(saftlib::SAFTd *saftd, const std::string name, const std::string etherbone_path, int poll_interval_ms) {
+/// @param poll_interval_us this is directly passed to AttachDeviceUs function
+void handle_wildcards_and_attach_device(saftlib::SAFTd *saftd, const std::string name, const std::string etherbone_path, int poll_interval_us) {
 	if (name.size() && name.back() == '*') {
 		if (etherbone_path.size() && etherbone_path.back() != '*') {
 			throw saftbus::Error(saftbus::Error::INVALID_ARGS, "if name has * wildcard as last char, etherbone_path also needs wildcard as last char");
@@ -74,7 +75,7 @@ void handle_wildcards_and_attach_device(saftlib::SAFTd *saftd, const std::string
 
 						std::cerr << "found name device pair "  << new_name << ":" << new_path << std::endl;
 						found_one = true;
-						saftd->AttachDevice(new_name, new_path, poll_interval_ms);
+						saftd->AttachDeviceUs(new_name, new_path, poll_interval_us);
 					}
 				}
 				if (!found_one) {
@@ -90,7 +91,7 @@ void handle_wildcards_and_attach_device(saftlib::SAFTd *saftd, const std::string
 			throw saftbus::Error(saftbus::Error::INVALID_ARGS, msg.str());
 		}
 	} else {
-		saftd->AttachDevice(name, etherbone_path, poll_interval_ms);
+		saftd->AttachDeviceUs(name, etherbone_path, poll_interval_us);
 	}
 }
 
@@ -103,7 +104,10 @@ void create_services(saftbus::Container *container, const std::vector<std::strin
 		throw std::runtime_error("service alreayd exists");
 	}
 
-	saftd = std::unique_ptr<saftlib::SAFTd>(new saftlib::SAFTd(container));
+	// "--device-threads" runs each attached device in its own thread
+	bool device_threads = std::find(args.begin(), args.end(), "--device-threads") != args.end();
+
+	saftd = std::unique_ptr<saftlib::SAFTd>(new saftlib::SAFTd(container, device_threads));
 	// create a new Service and return it. Maintain a reference count
 	container->create_object(saftd->getObjectPath(), std::move(std::unique_ptr<saftlib::SAFTd_Service>(new saftlib::SAFTd_Service(saftd.get(), std::bind(&destroy_service), false ))));
 
@@ -114,28 +118,39 @@ void create_services(saftbus::Container *container, const std::vector<std::strin
 	// then destroying the attached devices will result in segmentation faults (because the destruction_callback
 	// is part of SAFTd_Service which doesnt exist anymore)
 	for (auto &arg: args) {
+		if (arg == "--device-threads") {
+			continue;
+		}
 		size_t pos = arg.find(':'); // the position of the first colon ':'
 		if (pos == arg.npos || pos+1 == arg.size()) {
-			throw std::runtime_error("expect <name>:<eb-path>[:<poll-interval>] as argument");
+			throw std::runtime_error("expect <name>:<eb-path>[:<poll-interval>[us]] as argument");
 		}
 		std::string name = arg.substr(0, pos);
 		std::string path = arg.substr(pos+1);
-		int poll_interval_ms = 1;
+		int poll_interval_us = 1000;
 		size_t pos2 = path.find(':'); // the position of the second colon ':'
 		if (pos2 != path.npos) {
 			if (pos2+1 == path.size()) { // 2nd colon is there, but poll inteval is missing
-				throw std::runtime_error("expect <name>:<eb-path>[:<poll-interval>] as argument");
+				throw std::runtime_error("expect <name>:<eb-path>[:<poll-interval>[us]] as argument");
 			} 
+			// poll interval is in milliseconds, or in microseconds if followed by "us"
 			std::istringstream poll_interval(path.substr(pos2+1));
-			poll_interval >> poll_interval_ms;
-			if (!poll_interval || poll_interval_ms <= 0) {
+			std::string unit;
+			poll_interval >> poll_interval_us;
+			if (poll_interval && !(poll_interval >> unit)) {
+				poll_interval.clear();
+				poll_interval_us *= 1000;
+			} else if (unit != "us") {
+				poll_interval.setstate(std::ios::failbit);
+			}
+			if (!poll_interval || poll_interval_us <= 0) {
 				std::ostringstream msg;
 				msg << "cannot read poll interval from \'" << path.substr(pos2+1) << "\' after " << name << ":" << path << ":";
 				throw std::runtime_error(msg.str());
 			}
 			path = path.substr(0,pos2);
 		}
-		handle_wildcards_and_attach_device(saftd.get(), name, path, poll_interval_ms);
+		handle_wildcards_and_attach_device(saftd.get(), name, path, poll_interval_us);
 	}
 }
 
@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <unistd.h>
 
 #include "interfaces/SAFTd.h"
@@ -114,6 +115,7 @@ static void help(void) {
   std::cout << std::endl;
   std::cout << "  attach <path> [<poll-iv>]        instruct saftd to control a new device. " << std::endl;
   std::cout << "                                   <poll-iv> is the polling interval for MSI on USB devices (default is 1 ms)." << std::endl;
+  std::cout << "                                   <poll-iv> is in ms, or in us if followed by 'us' (e.g. 250us)." << std::endl;
   std::cout << "  remove                           remove the device from saftlib management " << std::endl;
   std::cout << "  quit                             instructs the saftlib daemon to quit " << std::endl << std::endl;
   std::cout << std::endl;
@@ -333,7 +335,7 @@ int main(int argc, char** argv)
   // variables attach, remove
   char    *deviceName = NULL;
   char    *devicePath = NULL;
-  int      devicePollIv = 1; // MSI polling interval in ms. only relevant if MSIs needs to be polled
+  int      devicePollIv = 1000; // MSI polling interval in us. only relevant if MSIs needs to be polled
 
   const char *command;
 
@@ -490,11 +492,14 @@ int main(int argc, char** argv)
         return 1;
       } // path
       if (optind+4 == argc) {
-        devicePollIv = atoi(argv[optind+3]);
-        if (devicePollIv <= 0) {
+        char *unit;
+        long pollIv = strtol(argv[optind+3], &unit, 10);
+        bool unitUs = strcmp(unit, "us") == 0; // default unit is ms
+        if (pollIv <= 0 || (strlen(unit) > 0 && !unitUs) || pollIv > (unitUs ? INT_MAX : INT_MAX/1000)) {
           std::cerr << program << ": invalid MSI polling interval -- " << argv[optind+3] << std::endl;
           return 1;
         }
+        devicePollIv = unitUs ? pollIv : pollIv*1000;
       }
     } // "attach"
 
@@ -540,7 +545,7 @@ int main(int argc, char** argv)
     // do commands for saftd management first
     // attach device
     if (deviceAttach) {
-      saftd->AttachDevice(deviceName, devicePath, devicePollIv);
+      saftd->AttachDeviceUs(deviceName, devicePath, devicePollIv);
     } // attach device
 
     // remove device
@@ -346,8 +346,20 @@ static int io_list (void)
           /* Helper for flag information field */
           uint32_t  flags = 0x0;
 
-          /* Get output conditions */
+          /* Get output conditions (all getters are executed with one round trip) */
           std::shared_ptr<OutputCondition_Proxy> info_condition = OutputCondition_Proxy::create(all_conditions[condition_it]);
+          saftbus::Batch batch;
+          auto id              = info_condition->getID_async();
+          auto mask            = info_condition->getMask_async();
+          auto offset          = info_condition->getOffset_async();
+          auto accept_delayed  = info_condition->getAcceptDelayed_async();
+          auto accept_conflict = info_condition->getAcceptConflict_async();
+          auto accept_early    = info_condition->getAcceptEarly_async();
+          auto accept_late     = info_condition->getAcceptLate_async();
+          auto on              = info_condition->getOn_async();
+          auto active          = info_condition->getActive_async();
+          auto owner           = info_condition->getOwner_async();
+          batch.execute();
           c_name = all_conditions[condition_it];
           std::string str_path_and_id = it->first;
           std::string str_path        = it->second;
@@ -363,27 +375,27 @@ static int io_list (void)
           std::cout << std::setw(12+2) << it->first << " ";
           std::cout << std::setw(10+1) << cid << " ";
           std::cout << "0x";
-          std::cout << std::setw(16+1) << std::hex << info_condition->getID() << " ";
+          std::cout << std::setw(16+1) << std::hex << id.get() << " ";
           std::cout << "0x";
-          std::cout << std::setw(16+1) << std::hex << info_condition->getMask() << " ";
+          std::cout << std::setw(16+1) << std::hex << mask.get() << " ";
           std::cout << std::dec;
-          std::cout << std::setw(10+1) << info_condition->getOffset() << " ";
-          if (info_condition->getAcceptDelayed())  { std::cout << "d"; flags = flags | (1<<ECA_DELAYED); }
-          else                                     { std::cout << "."; }
-          if (info_condition->getAcceptConflict()) { std::cout << "c"; flags = flags | (1<<ECA_CONFLICT); }
-          else                                     { std::cout << "."; }
-          if (info_condition->getAcceptEarly())    { std::cout << "e"; flags = flags | (1<<ECA_EARLY); }
-          else                                     { std::cout << "."; }
-          if (info_condition->getAcceptLate())     { std::cout << "l"; flags = flags | (1<<ECA_LATE); }
-          else                                     { std::cout << "."; }
+          std::cout << std::setw(10+1) << offset.get() << " ";
+          if (accept_delayed.get())  { std::cout << "d"; flags = flags | (1<<ECA_DELAYED); }
+          else                       { std::cout << "."; }
+          if (accept_conflict.get()) { std::cout << "c"; flags = flags | (1<<ECA_CONFLICT); }
+          else                       { std::cout << "."; }
+          if (accept_early.get())    { std::cout << "e"; flags = flags | (1<<ECA_EARLY); }
+          else                       { std::cout << "."; }
+          if (accept_late.get())     { std::cout << "l"; flags = flags | (1<<ECA_LATE); }
+          else                       { std::cout << "."; }
           std::cout << " (0x";
           std::cout << std::setw(1) << std::hex << flags << ")  ";
-          if (info_condition->getOn())             { std::cout << "Rising   "; }
-          else                                     { std::cout << "Falling  "; }
-          if (info_condition->getActive())         { std::cout << "Active    "; }
-          else                                     { std::cout << "Inactive  "; }
+          if (on.get())              { std::cout << "Rising   "; }
+          else                       { std::cout << "Falling  "; }
+          if (active.get())          { std::cout << "Active    "; }
+          else                       { std::cout << "Inactive  "; }
           std::cout << std::dec;
-          std::cout << info_condition->getOwner() << " ";
+          std::cout << owner.get() << " ";
           std::cout << std::endl;
         }
       }
@@ -0,0 +1,424 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+// End-to-end latency benchmark: timing events are injected into the ECA of a device
+// (e.g. a saft-software-tr) at different rates and received by a varying number of client processes.
+// For each event, the client records
+//   - deadline -> executed: delay of the ECA (from the SigAction arguments)
+//   - executed -> client:   ECA execution until the SigAction callback (MSI, saftbusd, IPC, client)
+//   - deadline -> client:   both of the above
+// The host clock of each client is mapped to the timing receiver time with CurrentTime().
+// The saftbusd-internal stages (MSI dispatch, queue read, serialize, emit) are taken from the
+// latency histograms of saftbusd (see "saftbus-ctl --latency"). Histogram recording is enabled
+// by the benchmark and disabled at the end.
+// The results are written as JSON.
+
+#include "SAFTd_Proxy.hpp"
+#include "TimingReceiver_Proxy.hpp"
+#include "SoftwareActionSink_Proxy.hpp"
+#include "SoftwareCondition_Proxy.hpp"
+#include "eca_flags.h"
+
+#include <saftbus/client.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <future>
+#include <cstdint>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+static const uint64_t BENCH_EVENT_ID = UINT64_C(0xbe0c000000000000);
+
+// commands from the benchmark process to the client processes
+struct Command {
+	int32_t point;     // -1 to end the client process
+	int32_t active;    // the client only receives events if it is active in this point
+	uint64_t events;   // number of events the client should wait for
+};
+// one measurement of a client
+struct Sample {
+	int64_t deadline_to_executed;
+	int64_t executed_to_client;
+	int64_t deadline_to_client;
+	uint16_t flags;
+};
+
+struct Worker {
+	pid_t pid;
+	int to_worker;
+	int from_worker;
+};
+
+static void write_all(int fd, const void *data, size_t size) {
+	const char *ptr = static_cast<const char*>(data);
+	while (size) {
+		ssize_t result = write(fd, ptr, size);
+		if (result <= 0) throw std::runtime_error(std::string("write to pipe failed: ") + strerror(errno));
+		ptr += result; size -= result;
+	}
+}
+static void read_all(int fd, void *data, size_t size) {
+	char *ptr = static_cast<char*>(data);
+	while (size) {
+		ssize_t result = read(fd, ptr, size);
+		if (result <= 0) throw std::runtime_error(std::string("read from pipe failed: ") + strerror(errno));
+		ptr += result; size -= result;
+	}
+}
+
+static int64_t host_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Offset between the host clock and the time of the timing receiver.
+// The call with the shortest round trip gives the best estimate.
+static int64_t clock_offset(std::shared_ptr<saftlib::TimingReceiver_Proxy> tr) {
+	int64_t best_roundtrip = INT64_MAX;
+	int64_t offset = 0;
+	for (int i = 0; i < 20; ++i) {
+		int64_t t0 = host_ns();
+		uint64_t tr_time = tr->CurrentTime().getTAI();
+		int64_t t1 = host_ns();
+		if (t1-t0 < best_roundtrip) {
+			best_roundtrip = t1-t0;
+			offset = static_cast<int64_t>(tr_time) - (t0+t1)/2;
+		}
+	}
+	return offset;
+}
+
+// state of the client process
+static int64_t offset;
+static int32_t point;
+static std::vector<Sample> samples;
+
+static void on_action(uint64_t id, uint64_t param, saftlib::Time deadline, saftlib::Time executed, uint16_t flags)
+{
+	int64_t received = host_ns() + offset;
+	if (static_cast<int32_t>(param >> 32) != point) {
+		return; // a leftover from a previous point
+	}
+	Sample sample;
+	sample.deadline_to_executed = executed - deadline;
+	sample.executed_to_client   = received - static_cast<int64_t>(executed.getTAI());
+	sample.deadline_to_client   = received - static_cast<int64_t>(deadline.getTAI());
+	sample.flags                = flags;
+	samples.push_back(sample);
+}
+
+// The client process. It must not use any saftbus connection of the parent process,
+// therefore it is forked before the parent process connects to saftbusd.
+static int run_worker(const std::string &device, int from_parent, int to_parent) {
+	auto tr        = saftlib::TimingReceiver_Proxy::create(std::string("/de/gsi/saftlib/")+device);
+	auto sink      = saftlib::SoftwareActionSink_Proxy::create(tr->NewSoftwareActionSink(""));
+	auto condition = saftlib::SoftwareCondition_Proxy::create(sink->NewCondition(false, BENCH_EVENT_ID, UINT64_C(0xffffffff00000000), 0));
+	condition->setAcceptEarly(true);
+	condition->setAcceptLate(true);
+	condition->setAcceptConflict(true);
+	condition->setAcceptDelayed(true);
+
+	condition->SigAction.connect(sigc::ptr_fun(&on_action));
+
+	for (;;) {
+		Command command;
+		read_all(from_parent, &command, sizeof(command));
+		if (command.point < 0) {
+			break;
+		}
+		point = command.point;
+		samples.clear();
+		samples.reserve(command.events);
+		condition->setActive(command.active);
+		offset = clock_offset(tr);
+		char ready = 1;
+		write_all(to_parent, &ready, 1);
+		if (command.active) {
+			// wait for all events, or until nothing arrived for 2 seconds
+			while (samples.size() < command.events) {
+				if (saftbus::SignalGroup::get_global().wait_for_signal(2000) <= 0) {
+					break;
+				}
+			}
+		}
+		uint64_t n_samples = samples.size();
+		write_all(to_parent, &n_samples, sizeof(n_samples));
+		if (n_samples) {
+			write_all(to_parent, &samples[0], n_samples*sizeof(Sample));
+		}
+	}
+	condition->Destroy();
+	sink->Destroy();
+	return 0;
+}
+
+static int64_t percentile(const std::vector<int64_t> &sorted, double p) {
+	if (sorted.empty()) return 0;
+	size_t idx = static_cast<size_t>(p*sorted.size());
+	return sorted[std::min(idx, sorted.size()-1)];
+}
+
+static void json_percentiles(std::ostream &out, std::vector<int64_t> values) {
+	std::sort(values.begin(), values.end());
+	out << "{\"count\": " << values.size();
+	if (!values.empty()) {
+		out << ", \"min\": "   << values.front()
+		    << ", \"p50\": "   << percentile(values, 0.5)
+		    << ", \"p99\": "   << percentile(values, 0.99)
+		    << ", \"p99.9\": " << percentile(values, 0.999)
+		    << ", \"max\": "   << values.back();
+	}
+	out << "}";
+}
+
+// bin i of a saftbus::LatencyHistogram counts durations in [2^i,2^(i+1)) ns, percentiles are upper bin edges
+static void json_histogram(std::ostream &out, const std::vector<uint64_t> &bins) {
+	uint64_t count = 0;
+	for (auto bin: bins) count += bin;
+	out << "{\"count\": " << count;
+	const double      ps[]    = {0.5, 0.99, 0.999};
+	const char *const names[] = {"p50", "p99", "p99.9"};
+	for (int p = 0; p < 3 && count; ++p) {
+		uint64_t sum = 0;
+		for (unsigned i = 0; i < bins.size(); ++i) {
+			sum += bins[i];
+			if (sum >= ps[p]*count) {
+				out << ", \"" << names[p] << "\": " << (uint64_t(2)<<i);
+				break;
+			}
+		}
+	}
+	out << "}";
+}
+
+static std::vector<double> parse_list(const std::string &arg) {
+	std::vector<double> result;
+	std::istringstream in(arg);
+	std::string item;
+	while (std::getline(in, item, ',')) {
+		std::istringstream item_in(item);
+		double value;
+		item_in >> value;
+		if (!item_in || value <= 0) {
+			throw std::runtime_error("invalid list: " + arg);
+		}
+		result.push_back(value);
+	}
+	return result;
+}
+
+static void usage(const char *argv0) {
+	std::cerr << "End-to-end latency benchmark: inject timing events into a device at different rates and " << std::endl;
+	std::cerr << "measure the latency until they arrive at a number of client processes." << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "usage: " << argv0 << " <saftlib-device> [options]" << std::endl;
+	std::cerr << "   --rates <r1,r2,...>     event rates in Hz (default 100,1000,10000)" << std::endl;
+	std::cerr << "   --clients <c1,c2,...>   number of client processes (default 1,4)" << std::endl;
+	std::cerr << "   --events <n>            number of events per rate and client count (default 1000)" << std::endl;
+	std::cerr << "   --lead <us>             events are injected this much before their deadline (default 1000)" << std::endl;
+	std::cerr << "   --output <file>         write JSON to file instead of stdout" << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "   example: " << argv0 << " tr0 --rates 100,1000 --clients 1,2,8 --output latency.json" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2 || argv[1][0] == '-') {
+		usage(argv[0]);
+		return 1;
+	}
+	std::string device(argv[1]);
+	std::vector<double> rates   = {100, 1000, 10000};
+	std::vector<double> clients = {1, 4};
+	uint64_t events = 1000;
+	int64_t lead_ns = 1000000;
+	std::string output;
+	try {
+		for (int i = 2; i < argc; ++i) {
+			std::string argvi(argv[i]);
+			if (i+1 >= argc) {
+				throw std::runtime_error("expect value after " + argvi);
+			}
+			std::string value(argv[++i]);
+			if      (argvi == "--rates")   rates   = parse_list(value);
+			else if (argvi == "--clients") clients = parse_list(value);
+			else if (argvi == "--events")  events  = parse_list(value).at(0);
+			else if (argvi == "--lead")    lead_ns = parse_list(value).at(0)*1000;
+			else if (argvi == "--output")  output  = value;
+			else throw std::runtime_error("unknown argument " + argvi);
+		}
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		usage(argv[0]);
+		return 1;
+	}
+
+	// fork the client processes before this process connects to saftbusd
+	unsigned max_clients = *std::max_element(clients.begin(), clients.end());
+	std::vector<Worker> workers;
+	for (unsigned i = 0; i < max_clients; ++i) {
+		int down[2], up[2];
+		if (pipe(down) || pipe(up)) {
+			std::cerr << "Error: cannot create pipe" << std::endl;
+			return 1;
+		}
+		pid_t pid = fork();
+		if (pid == 0) {
+			close(down[1]); close(up[0]);
+			for (auto &worker: workers) {
+				close(worker.to_worker); close(worker.from_worker);
+			}
+			try {
+				return run_worker(device, down[0], up[1]);
+			} catch (std::exception &e) {
+				std::cerr << "Error in client " << i << ": " << e.what() << std::endl;
+				return 1;
+			}
+		}
+		close(down[0]); close(up[1]);
+		workers.push_back(Worker{pid, down[1], up[0]});
+	}
+
+	int result = 0;
+	std::ostringstream json;
+	try {
+		auto tr        = saftlib::TimingReceiver_Proxy::create(std::string("/de/gsi/saftlib/")+device);
+		auto container = saftbus::Container_Proxy::create();
+
+		json << "{" << std::endl;
+		json << "  \"device\": \"" << device << "\"," << std::endl;
+		json << "  \"events\": " << events << "," << std::endl;
+		json << "  \"lead_ns\": " << lead_ns << "," << std::endl;
+		json << "  \"points\": [";
+		int32_t point = 0;
+		for (auto rate: rates) {
+			for (auto n_clients: clients) {
+				std::cerr << "rate " << rate << " Hz, " << n_clients << " clients" << std::endl;
+				for (unsigned i = 0; i < workers.size(); ++i) {
+					Command command = {point, i < n_clients, events};
+					write_all(workers[i].to_worker, &command, sizeof(command));
+				}
+				for (auto &worker: workers) {
+					char ready;
+					read_all(worker.from_worker, &ready, 1);
+				}
+				container->set_latency_histograms(true, true);
+
+				// inject the events shortly before their deadline, all events that are due are sent in one batch
+				int64_t offset = clock_offset(tr);
+				int64_t period_ns = 1e9/rate;
+				int64_t first_deadline = host_ns() + offset + lead_ns;
+				uint64_t injected = 0;
+				while (injected < events) {
+					int64_t now = host_ns() + offset;
+					saftbus::Batch batch;
+					std::vector<std::future<void> > replies;
+					for (; injected < events && first_deadline + (int64_t)injected*period_ns - lead_ns <= now; ++injected) {
+						uint64_t param = (static_cast<uint64_t>(point) << 32) | injected;
+						replies.push_back(tr->InjectEvent_async(BENCH_EVENT_ID, param, saftlib::makeTimeTAI(first_deadline + injected*period_ns)));
+					}
+					batch.execute();
+					for (auto &reply: replies) {
+						reply.get();
+					}
+					if (injected < events) {
+						int64_t next = first_deadline + (int64_t)injected*period_ns - lead_ns;
+						int64_t wait = next - (host_ns() + offset);
+						if (wait > 0) {
+							std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+						}
+					}
+				}
+
+				std::vector<int64_t> deadline_to_executed, executed_to_client, deadline_to_client;
+				uint64_t flagged = 0;
+				for (auto &worker: workers) {
+					uint64_t n_samples;
+					read_all(worker.from_worker, &n_samples, sizeof(n_samples));
+					std::vector<Sample> samples(n_samples);
+					if (n_samples) {
+						read_all(worker.from_worker, &samples[0], n_samples*sizeof(Sample));
+					}
+					for (auto &sample: samples) {
+						deadline_to_executed.push_back(sample.deadline_to_executed);
+						executed_to_client.push_back(sample.executed_to_client);
+						deadline_to_client.push_back(sample.deadline_to_client);
+						if (sample.flags & ((1<<ECA_LATE)|(1<<ECA_EARLY)|(1<<ECA_CONFLICT)|(1<<ECA_DELAYED))) {
+							++flagged;
+						}
+					}
+				}
+				auto histograms = container->get_latency_histograms();
+
+				json << (point?",":"") << std::endl;
+				json << "    {\"rate_hz\": " << rate << ", \"clients\": " << n_clients
+				     << ", \"expected\": " << events*(uint64_t)n_clients << ", \"received\": " << deadline_to_client.size()
+				     << ", \"flagged\": " << flagged << "," << std::endl;
+				json << "     \"latency_ns\": {" << std::endl;
+				json << "       \"deadline_to_executed\": "; json_percentiles(json, deadline_to_executed); json << "," << std::endl;
+				json << "       \"executed_to_client\": ";   json_percentiles(json, executed_to_client);   json << "," << std::endl;
+				json << "       \"deadline_to_client\": ";   json_percentiles(json, deadline_to_client);   json << std::endl;
+				json << "     }," << std::endl;
+				json << "     \"saftbusd_ns\": {";
+				bool first = true;
+				for (auto &histogram: histograms) {
+					json << (first?"":",") << std::endl << "       \"" << histogram.first << "\": ";
+					json_histogram(json, histogram.second);
+					first = false;
+				}
+				json << std::endl << "     }" << std::endl;
+				json << "    }";
+				++point;
+			}
+		}
+		json << std::endl << "  ]" << std::endl;
+		json << "}" << std::endl;
+		container->set_latency_histograms(false, false);
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		result = 1;
+	}
+
+	for (auto &worker: workers) {
+		Command command = {-1, 0, 0};
+		try {
+			write_all(worker.to_worker, &command, sizeof(command));
+		} catch (std::exception &e) {
+		}
+		close(worker.to_worker);
+		close(worker.from_worker);
+		waitpid(worker.pid, nullptr, 0);
+	}
+
+	if (result == 0) {
+		if (output.empty()) {
+			std::cout << json.str();
+		} else {
+			std::ofstream out(output);
+			out << json.str();
+		}
+	}
+	return result;
+}
@@ -0,0 +1,153 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+// Record timing events into a binary file (see ActionFile.hpp) instead of printing them.
+// The actions are received in batches (SoftwareCondition::SigActions) and written
+// unformatted, so the recorder keeps up with event rates where "saft-ctl snoop" doesn't.
+// The file can be replayed with saft-replay.
+
+#include "TimingReceiver_Proxy.hpp"
+#include "SoftwareActionSink_Proxy.hpp"
+#include "SoftwareCondition_Proxy.hpp"
+#include "ActionFile.hpp"
+
+#include <saftbus/client.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <csignal>
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int)
+{
+	stop = 1;
+}
+
+static uint64_t parse_number(const std::string &value)
+{
+	std::istringstream in(value);
+	uint64_t result;
+	if (value.size() > 2 && value[0] == '0' && (value[1] == 'x' || value[1] == 'X')) {
+		in.ignore(2);
+		in >> std::hex >> result;
+	} else {
+		in >> result;
+	}
+	if (!in || !in.eof()) {
+		throw std::runtime_error("invalid number: " + value);
+	}
+	return result;
+}
+
+static void usage(const char *argv0) {
+	std::cerr << "Record timing events of a device into a binary file that can be replayed with saft-replay." << std::endl;
+	std::cerr << "Recording stops after the given time or number of events, or with Ctrl-C." << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "usage: " << argv0 << " <saftlib-device> <file> [options]" << std::endl;
+	std::cerr << "   --id <id>           event id of the condition (default 0)" << std::endl;
+	std::cerr << "   --mask <mask>       event mask of the condition (default 0, i.e. all events)" << std::endl;
+	std::cerr << "   --offset <ns>       offset of the condition (default 0)" << std::endl;
+	std::cerr << "   --seconds <s>       stop after this many seconds" << std::endl;
+	std::cerr << "   --count <n>         stop after this many events" << std::endl;
+	std::cerr << "   --window <us>       BatchWindow of the condition (default 10000)" << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "   example: " << argv0 << " tr0 events.saftact --id 0x1154000000000000 --mask 0xfffff00000000000 --seconds 60" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3 || argv[1][0] == '-' || argv[2][0] == '-') {
+		usage(argv[0]);
+		return 1;
+	}
+	std::string device(argv[1]);
+	std::string filename(argv[2]);
+	uint64_t id = 0, mask = 0, count = 0, seconds = 0;
+	int64_t offset = 0;
+	uint32_t window_us = 10000;
+	try {
+		for (int i = 3; i < argc; ++i) {
+			std::string argvi(argv[i]);
+			if (i+1 >= argc) {
+				throw std::runtime_error("expect value after " + argvi);
+			}
+			std::string value(argv[++i]);
+			if      (argvi == "--id")      id        = parse_number(value);
+			else if (argvi == "--mask")    mask      = parse_number(value);
+			else if (argvi == "--offset")  offset    = std::stoll(value);
+			else if (argvi == "--seconds") seconds   = parse_number(value);
+			else if (argvi == "--count")   count     = parse_number(value);
+			else if (argvi == "--window")  window_us = parse_number(value);
+			else throw std::runtime_error("unknown argument " + argvi);
+		}
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		saftlib::ActionFileWriter file(filename, id, mask, offset);
+
+		auto tr        = saftlib::TimingReceiver_Proxy::create(std::string("/de/gsi/saftlib/")+device);
+		auto sink      = saftlib::SoftwareActionSink_Proxy::create(tr->NewSoftwareActionSink(""));
+		auto condition = saftlib::SoftwareCondition_Proxy::create(sink->NewCondition(false, id, mask, offset));
+		condition->setAcceptEarly(true);
+		condition->setAcceptLate(true);
+		condition->setAcceptConflict(true);
+		condition->setAcceptDelayed(true);
+		condition->setBatchWindow(window_us);
+		condition->setBatchActions(true);
+
+		condition->SigActions.connect([&file, count](std::vector<saftlib::ActionRecord> actions) {
+			for (auto &action: actions) {
+				if (count && file.size() >= count) {
+					break;
+				}
+				file.write(action);
+			}
+		});
+
+		signal(SIGINT,  &on_signal);
+		signal(SIGTERM, &on_signal);
+
+		condition->setActive(true);
+		std::cerr << "recording to " << filename << std::endl;
+		auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+		while (!stop && (!count || file.size() < count)) {
+			if (seconds && std::chrono::steady_clock::now() >= end) {
+				break;
+			}
+			// the timeout makes sure that a signal or the end of the recording is noticed
+			saftbus::SignalGroup::get_global().wait_for_signal(100);
+		}
+		condition->setActive(false);
+		condition->Destroy();
+		sink->Destroy();
+
+		file.close();
+		std::cerr << file.size() << " events recorded" << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,174 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+// Replay a file that was recorded by saft-record: the events are injected into the ECA
+// of a device (TimingReceiver::InjectEvent) with the same time differences between their
+// deadlines as in the recording, optionally faster or slower. The device can be a real
+// timing receiver or one provided by saft-software-tr.
+// Events are injected shortly before their deadline, all events that are due are sent in one batch.
+
+#include "TimingReceiver_Proxy.hpp"
+#include "ActionFile.hpp"
+
+#include <saftbus/client.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <cstdint>
+
+static const uint64_t MAX_BATCH = 1024;
+
+static int64_t host_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Offset between the host clock and the time of the timing receiver.
+// The call with the shortest round trip gives the best estimate.
+static int64_t clock_offset(std::shared_ptr<saftlib::TimingReceiver_Proxy> tr) {
+	int64_t best_roundtrip = INT64_MAX;
+	int64_t offset = 0;
+	for (int i = 0; i < 20; ++i) {
+		int64_t t0 = host_ns();
+		uint64_t tr_time = tr->CurrentTime().getTAI();
+		int64_t t1 = host_ns();
+		if (t1-t0 < best_roundtrip) {
+			best_roundtrip = t1-t0;
+			offset = static_cast<int64_t>(tr_time) - (t0+t1)/2;
+		}
+	}
+	return offset;
+}
+
+static void dump(const saftlib::ActionFileReader &file, uint64_t first, uint64_t last) {
+	const saftlib::ActionFileHeader &header = file.get_header();
+	std::cout << "# " << file.size() << " events, condition id 0x" << std::hex << std::setfill('0') << std::setw(16) << header.event_id
+	          << " mask 0x" << std::setw(16) << header.event_mask << std::dec << " offset " << header.offset << std::endl;
+	std::cout << "# event param deadline executed flags" << std::endl;
+	for (uint64_t i = first; i < last; ++i) {
+		const saftlib::ActionFileRecord &record = file[i];
+		std::cout << "0x" << std::hex << std::setw(16) << record.event << " 0x" << std::setw(16) << record.param << std::dec
+		          << " " << record.deadline << " " << record.executed << " 0x" << std::hex << record.flags << std::dec << std::endl;
+	}
+}
+
+static void usage(const char *argv0) {
+	std::cerr << "Inject the events of a file that was recorded by saft-record into a device." << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "usage: " << argv0 << " <saftlib-device> <file> [options]" << std::endl;
+	std::cerr << "       " << argv0 << " --dump <file> [options]" << std::endl;
+	std::cerr << "   --speed <factor>    replay faster (>1) or slower (<1) than recorded (default 1)" << std::endl;
+	std::cerr << "   --from <tai>        start with the first event executed at or after this time (ns)" << std::endl;
+	std::cerr << "   --to <tai>          stop before the first event executed at or after this time (ns)" << std::endl;
+	std::cerr << "   --delay <ms>        the first event is due this much after the start (default 100)" << std::endl;
+	std::cerr << "   --lead <us>         events are injected this much before their deadline (default 1000)" << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "   --dump prints the events as text instead of injecting them." << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "   example: " << argv0 << " tr0 events.saftact --speed 10" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3 || (argv[1][0] == '-' && std::string(argv[1]) != "--dump") || argv[2][0] == '-') {
+		usage(argv[0]);
+		return 1;
+	}
+	std::string device(argv[1]);
+	std::string filename(argv[2]);
+	bool dump_only = device == "--dump";
+	double speed = 1;
+	uint64_t from = 0, to = UINT64_MAX;
+	int64_t delay_ns = 100000000;
+	int64_t lead_ns  = 1000000;
+	try {
+		for (int i = 3; i < argc; ++i) {
+			std::string argvi(argv[i]);
+			if (i+1 >= argc) {
+				throw std::runtime_error("expect value after " + argvi);
+			}
+			std::string value(argv[++i]);
+			if      (argvi == "--speed") speed    = std::stod(value);
+			else if (argvi == "--from")  from     = std::stoull(value);
+			else if (argvi == "--to")    to       = std::stoull(value);
+			else if (argvi == "--delay") delay_ns = std::stod(value)*1000000;
+			else if (argvi == "--lead")  lead_ns  = std::stod(value)*1000;
+			else throw std::runtime_error("unknown argument " + argvi);
+		}
+		if (speed <= 0) {
+			throw std::runtime_error("speed must be positive");
+		}
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		saftlib::ActionFileReader file(filename);
+		uint64_t first = file.find(from);
+		uint64_t last  = file.find(to);
+		if (dump_only) {
+			dump(file, first, last);
+			return 0;
+		}
+		if (first >= last) {
+			std::cerr << "no events to replay" << std::endl;
+			return 0;
+		}
+
+		// All records were delivered by the same condition and carry the same offset,
+		// so the differences between the deadlines are the differences between the event times.
+		auto tr = saftlib::TimingReceiver_Proxy::create(std::string("/de/gsi/saftlib/")+device);
+		int64_t offset = clock_offset(tr);
+		int64_t start = host_ns() + offset + delay_ns;
+		int64_t first_deadline = file[first].deadline;
+		auto event_time = [&](uint64_t i) -> int64_t {
+			return start + static_cast<int64_t>((static_cast<int64_t>(file[i].deadline) - first_deadline)/speed);
+		};
+
+		uint64_t injected = first;
+		while (injected < last) {
+			int64_t now = host_ns() + offset;
+			saftbus::Batch batch;
+			std::vector<std::future<void> > replies;
+			for (; injected < last && replies.size() < MAX_BATCH && event_time(injected) - lead_ns <= now; ++injected) {
+				replies.push_back(tr->InjectEvent_async(file[injected].event, file[injected].param, saftlib::makeTimeTAI(event_time(injected))));
+			}
+			batch.execute();
+			for (auto &reply: replies) {
+				reply.get();
+			}
+			if (injected < last) {
+				int64_t wait = event_time(injected) - lead_ns - (host_ns() + offset);
+				if (wait > 0) {
+					std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+				}
+			}
+		}
+		std::cerr << last-first << " events injected" << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
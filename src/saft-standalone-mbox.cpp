@@ -22,7 +22,7 @@ struct LM32testbench : public saftlib::OpenDevice
 	std::unique_ptr<saftlib::IRQ> msi_irq_to_this_program;
 
 	LM32testbench(saftlib::SAFTd &saftd, const std::string &eb_path) 
-		: OpenDevice(saftd.get_etherbone_socket(), eb_path, 10, &saftd)
+		: OpenDevice(saftd.get_etherbone_socket(), eb_path, std::chrono::milliseconds(10), &saftd)
 		, Mailbox(OpenDevice::device)
 	{
 		msi_irq_to_this_program = saftd.request_irq(*this, std::bind(&LM32testbench::receiveMSI,this, std::placeholders::_1));
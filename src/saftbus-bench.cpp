@@ -0,0 +1,291 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+// Throughput benchmark for saftbus, independent of timing hardware.
+// It uses the services of the plugin libsaftbus-bench-service.so and measures
+//   - remote calls per second and call latency (SaftbusBench::Echo) 
+//   - signal fan-out rate and signal latency (SaftbusBench::SigData)
+// for a range of payload sizes and numbers of client threads. Each client thread has its own
+// connection to saftbusd. The results are written as JSON.
+
+#include "SaftbusBench_Proxy.hpp"
+
+#include <saftbus/client.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+
+static int64_t now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t percentile(const std::vector<int64_t> &sorted, double p) {
+	if (sorted.empty()) return 0;
+	size_t idx = static_cast<size_t>(p*sorted.size());
+	return sorted[std::min(idx, sorted.size()-1)];
+}
+
+static void json_percentiles(std::ostream &out, std::vector<int64_t> values) {
+	std::sort(values.begin(), values.end());
+	out << "{\"count\": " << values.size();
+	if (!values.empty()) {
+		out << ", \"p50\": "   << percentile(values, 0.5)
+		    << ", \"p99\": "   << percentile(values, 0.99)
+		    << ", \"p99.9\": " << percentile(values, 0.999)
+		    << ", \"max\": "   << values.back();
+	}
+	out << "}";
+}
+
+static std::vector<unsigned> parse_list(const std::string &arg) {
+	std::vector<unsigned> result;
+	std::istringstream in(arg);
+	std::string item;
+	while (std::getline(in, item, ',')) {
+		std::istringstream item_in(item);
+		unsigned value;
+		item_in >> value;
+		if (!item_in) {
+			throw std::runtime_error("invalid list: " + arg);
+		}
+		result.push_back(value);
+	}
+	return result;
+}
+
+// wait until all threads arrived
+class Barrier {
+public:
+	Barrier(unsigned n) : count(n) {}
+	void wait() {
+		--count;
+		while (count > 0) {
+			std::this_thread::yield();
+		}
+	}
+private:
+	std::atomic<int> count;
+};
+
+static std::string service_path(const std::string &prefix, unsigned i) {
+	std::ostringstream path;
+	path << prefix << "/" << i;
+	return path.str();
+}
+
+// Each client thread calls Echo n_calls times. Client i uses service i%n_services.
+static void bench_calls(std::ostream &json, const std::string &prefix, unsigned n_services, unsigned n_clients, unsigned size, unsigned n_calls) {
+	std::vector<std::vector<int64_t> > latencies(n_clients);
+	std::vector<std::thread> clients;
+	Barrier connected(n_clients+1), started(n_clients+1);
+	std::atomic<bool> failed(false);
+	for (unsigned i = 0; i < n_clients; ++i) {
+		clients.emplace_back([&, i]() {
+			saftbus::SignalGroup group(true);
+			std::shared_ptr<saftlib::SaftbusBench_Proxy> bench;
+			try {
+				bench = saftlib::SaftbusBench_Proxy::create(service_path(prefix, i%n_services), group);
+			} catch (std::exception &e) {
+				std::cerr << "Error: " << e.what() << std::endl;
+				failed = true;
+			}
+			std::vector<uint8_t> payload(size, i);
+			latencies[i].reserve(n_calls);
+			connected.wait();
+			started.wait();
+			if (!bench) return;
+			for (unsigned n = 0; n < n_calls; ++n) {
+				int64_t start = now_ns();
+				bench->Echo(payload);
+				latencies[i].push_back(now_ns() - start);
+			}
+		});
+	}
+	connected.wait();
+	int64_t start = now_ns();
+	started.wait();
+	for (auto &client: clients) {
+		client.join();
+	}
+	int64_t duration = now_ns() - start;
+	if (failed) {
+		throw std::runtime_error("cannot connect to saftbus-bench services, is libsaftbus-bench-service.so loaded?");
+	}
+	std::vector<int64_t> all;
+	for (auto &l: latencies) all.insert(all.end(), l.begin(), l.end());
+	json << "    {\"test\": \"calls\", \"size\": " << size << ", \"clients\": " << n_clients 
+	     << ", \"calls_per_s\": " << static_cast<uint64_t>(all.size()*1e9/duration)
+	     << ", \"latency_ns\": ";
+	json_percentiles(json, all);
+	json << "}";
+}
+
+// Each client thread connects to SigData of service 0, then n_signals are emitted in chunks.
+// Signals that don't fit into the buffers of saftbusd are dropped; "received" shows how many arrived.
+static void bench_signals(std::ostream &json, const std::string &prefix, unsigned n_clients, unsigned size, unsigned n_signals, unsigned chunk) {
+	std::vector<std::vector<int64_t> > latencies(n_clients);
+	std::vector<int64_t> last(n_clients, 0); // time of the last received signal
+	std::vector<std::thread> clients;
+	Barrier connected(n_clients+1);
+	std::atomic<bool> failed(false);
+	for (unsigned i = 0; i < n_clients; ++i) {
+		clients.emplace_back([&, i]() {
+			saftbus::SignalGroup group(true);
+			std::shared_ptr<saftlib::SaftbusBench_Proxy> bench;
+			try {
+				bench = saftlib::SaftbusBench_Proxy::create(service_path(prefix, 0), group);
+			} catch (std::exception &e) {
+				std::cerr << "Error: " << e.what() << std::endl;
+				failed = true;
+			}
+			latencies[i].reserve(n_signals);
+			if (bench) {
+				bench->SigData = [&latencies, &last, i](uint32_t, int64_t time_ns, std::vector<uint8_t>) {
+					last[i] = now_ns();
+					latencies[i].push_back(last[i] - time_ns);
+				};
+			}
+			connected.wait();
+			if (!bench) return;
+			// wait for all signals, or until nothing arrived for 2 seconds (dropped signals)
+			while (latencies[i].size() < n_signals) {
+				if (group.wait_for_signal(2000) <= 0) {
+					break;
+				}
+			}
+		});
+	}
+	connected.wait();
+	if (failed) {
+		for (auto &client: clients) {
+			client.join();
+		}
+		throw std::runtime_error("cannot connect to saftbus-bench services, is libsaftbus-bench-service.so loaded?");
+	}
+	auto bench = saftlib::SaftbusBench_Proxy::create(service_path(prefix, 0));
+	int64_t start = now_ns();
+	for (unsigned n = 0; n < n_signals; n += chunk) {
+		bench->Emit(std::min(chunk, n_signals-n), size);
+	}
+	for (auto &client: clients) {
+		client.join();
+	}
+	std::vector<int64_t> all;
+	int64_t end = start;
+	for (unsigned i = 0; i < n_clients; ++i) {
+		all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+		end = std::max(end, last[i]);
+	}
+	json << "    {\"test\": \"signals\", \"size\": " << size << ", \"clients\": " << n_clients 
+	     << ", \"expected\": " << static_cast<uint64_t>(n_signals)*n_clients << ", \"received\": " << all.size()
+	     << ", \"signals_per_s\": " << (end > start ? static_cast<uint64_t>(all.size()*1e9/(end-start)) : 0)
+	     << ", \"latency_ns\": ";
+	json_percentiles(json, all);
+	json << "}";
+}
+
+static void usage(const char *argv0) {
+	std::cerr << "saftbus throughput benchmark. Needs a running saftbusd with the plugin libsaftbus-bench-service.so, e.g." << std::endl;
+	std::cerr << "   saftbusd libsaftbus-bench-service.so /saftbus-bench <number-of-threads>" << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "usage: " << argv0 << " [options]" << std::endl;
+	std::cerr << "   --clients <c1,c2,...>   number of client threads (default 1,2,4)" << std::endl;
+	std::cerr << "   --sizes <s1,s2,...>     payload sizes in bytes (default 16,1024,65536)" << std::endl;
+	std::cerr << "   --calls <n>             number of calls per client (default 10000)" << std::endl;
+	std::cerr << "   --signals <n>           number of emitted signals (default 10000)" << std::endl;
+	std::cerr << "   --chunk <n>             number of signals emitted per call (default 64)" << std::endl;
+	std::cerr << "   --services <n>          number of services in the plugin, i.e. <number-of-threads> (default 1)" << std::endl;
+	std::cerr << "   --object-path <prefix>  object path prefix of the services (default /saftbus-bench)" << std::endl;
+	std::cerr << "   --output <file>         write JSON to file instead of stdout" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+	std::vector<unsigned> clients = {1, 2, 4};
+	std::vector<unsigned> sizes   = {16, 1024, 65536};
+	unsigned n_calls    = 10000;
+	unsigned n_signals  = 10000;
+	unsigned chunk      = 64;
+	unsigned n_services = 1;
+	std::string prefix  = "/saftbus-bench";
+	std::string output;
+	try {
+		for (int i = 1; i < argc; ++i) {
+			std::string argvi(argv[i]);
+			if (argvi == "-h" || argvi == "--help") {
+				usage(argv[0]);
+				return 0;
+			}
+			if (i+1 >= argc) {
+				throw std::runtime_error("expect value after " + argvi);
+			}
+			std::string value(argv[++i]);
+			if      (argvi == "--clients")     clients    = parse_list(value);
+			else if (argvi == "--sizes")       sizes      = parse_list(value);
+			else if (argvi == "--calls")       n_calls    = parse_list(value).at(0);
+			else if (argvi == "--signals")     n_signals  = parse_list(value).at(0);
+			else if (argvi == "--chunk")       chunk      = std::max(parse_list(value).at(0), 1u);
+			else if (argvi == "--services")    n_services = std::max(parse_list(value).at(0), 1u);
+			else if (argvi == "--object-path") prefix     = value;
+			else if (argvi == "--output")      output     = value;
+			else throw std::runtime_error("unknown argument " + argvi);
+		}
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		std::ostringstream json;
+		json << "{" << std::endl;
+		json << "  \"services\": " << n_services << "," << std::endl;
+		json << "  \"results\": [" << std::endl;
+		bool first = true;
+		for (auto size: sizes) {
+			for (auto n_clients: clients) {
+				std::cerr << "size " << size << ", " << n_clients << " clients" << std::endl;
+				json << (first?"":",\n");
+				bench_calls(json, prefix, n_services, n_clients, size, n_calls);
+				json << "," << std::endl;
+				bench_signals(json, prefix, n_clients, size, n_signals, chunk);
+				first = false;
+			}
+		}
+		json << std::endl << "  ]" << std::endl;
+		json << "}" << std::endl;
+		if (output.empty()) {
+			std::cout << json.str();
+		} else {
+			std::ofstream out(output);
+			out << json.str();
+		}
+	} catch (std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,79 @@
+/** Copyright (C) 2021-2022 GSI Helmholtz Centre for Heavy Ion Research GmbH 
+ *
+ *  @author Michael Reese <m.reese@gsi.de>
+ *
+ *******************************************************************************
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 3 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#include "SaftbusBench.hpp"
+#include "SaftbusBench_Service.hpp"
+
+#include <saftbus/service.hpp>
+#include <saftbus/loop.hpp>
+#include <saftbus/error.hpp>
+
+#include <memory>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+
+// args: [<object-path-prefix> [<number-of-threads>]]
+//   The services are created under <object-path-prefix>/0 .. <object-path-prefix>/<n-1> (default prefix is /saftbus-bench).
+//   If <number-of-threads> is 0 (default), one service is created in the main loop of saftbusd.
+//   Otherwise, that many services are created, each in its own saftbus::LoopThread.
+
+static std::vector<std::unique_ptr<saftlib::SaftbusBench> >  benches;
+static std::vector<std::unique_ptr<saftbus::LoopThread> >    threads;
+
+// destruction callback of the i-th service, called in the thread of that service
+static void destroy_bench(unsigned i) {
+	benches[i].reset();
+}
+
+extern "C" 
+void create_services(saftbus::Container *container, const std::vector<std::string> &args) {
+	if (!benches.empty()) {
+		throw saftbus::Error(saftbus::Error::INVALID_ARGS, "saftbus-bench services were already created");
+	}
+	std::string prefix = "/saftbus-bench";
+	unsigned n_threads = 0;
+	if (args.size() > 0) {
+		prefix = args[0];
+	}
+	if (args.size() > 1) {
+		std::istringstream in(args[1]);
+		in >> n_threads;
+		if (!in) {
+			throw saftbus::Error(saftbus::Error::INVALID_ARGS, "cannot read number of threads from " + args[1]);
+		}
+	}
+	for (unsigned i = 0; i < std::max(n_threads, 1u); ++i) {
+		std::ostringstream object_path;
+		object_path << prefix << "/" << i;
+		benches.push_back(std::unique_ptr<saftlib::SaftbusBench>(new saftlib::SaftbusBench));
+		saftlib::SaftbusBench *bench = benches.back().get();
+		auto create = [container, bench, i, &object_path]() {
+			container->create_object(object_path.str(), std::unique_ptr<saftlib::SaftbusBench_Service>(new saftlib::SaftbusBench_Service(bench, std::bind(&destroy_bench, i))));
+		};
+		if (n_threads) {
+			threads.push_back(std::unique_ptr<saftbus::LoopThread>(new saftbus::LoopThread));
+			threads.back()->get_loop().invoke_and_wait(create);
+		} else {
+			create();
+		}
+	}
+}